@@ -1,14 +1,45 @@
+// Cells are encoded on the host by Maze::encodeCells: bit k is set if the
+// move in direction k (left, right, up, down) stays inside the maze and
+// enters an open cell, CELL_OPEN marks the open cells themselves.
+#define CELL_OPEN 0x10
+
+inline int cell_moves(uchar c) {
+    return c & 0xF;
+}
+
+// Cell layout of the grids, the host selects it with -DCELL_LAYOUT
+#include "../shared/cell_layout.h"
+#ifndef CELL_LAYOUT
+#define CELL_LAYOUT LAYOUT_ROW_MAJOR
+#endif
+
+// Variants specialized for one maze get its size with -DMAZE_W and -DMAZE_H,
+// see Maze::kernelOptions. Kernels taking W and H start with FIX_DIMS so the
+// index arithmetic folds into constants and the size arguments are ignored.
+#if defined(MAZE_W) && defined(MAZE_H)
+#define FIX_DIMS(W, H) W = MAZE_W; H = MAZE_H
+#else
+#define FIX_DIMS(W, H)
+#endif
+
+// Index of the neighbor in direction k in a row-major grid of width W, only
+// used for the local tile arrays, global grids go through layout_neighbor.
+inline int neighbor_idx(int W, int idx, int k) {
+    return idx + ((k==0)?-1: (k==1)?1: (k==2)?-W:W);
+}
+
 __kernel void expand_wave_naive(
     int W, int H,
-    __global const int *cost,
+    __global const uchar *cells,
     __global uchar *wf_prev,
     __global uchar *wf_next,
     __global int *dist,
     int targetIdx,
     __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
 ) {
+    FIX_DIMS(W, H);
     int idx = get_global_id(0);
-    if (idx >= W*H)
+    if (idx >= layout_cells(CELL_LAYOUT, W, H))
         return;
     
     // Return if not in wavefront
@@ -22,23 +53,16 @@ __kernel void expand_wave_naive(
 
     // Get the distance set in the previous expansion
     int dcurr = dist[idx];
-    int x = idx % W;
-    int y = idx / W;
+    int moves = cell_moves(cells[idx]);
 
     // Check and add neighbors to next wavefront
     for (int k = 0; k < 4; k++) {
-        int nx = x + ((k==0)?-1: (k==1)?1:0);
-        int ny = y + ((k==2)?-1: (k==3)?1:0);
-        
-        if (nx < 0 || nx >= W || ny < 0 || ny >= H)
-            continue;
-        
-        int j = ny*W + nx;
-        
-        // Skip walls
-        if (cost[j] < 0)
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
             continue;
 
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
         // Check and add neighbors to next wavefront
         int old = atomic_cmpxchg(&dist[j], -1, dcurr + 1);
         if (old == -1) {
@@ -47,23 +71,37 @@ __kernel void expand_wave_naive(
     }
 }
 
+// Compacted wavefront lists
+#include "../shared/wave_list.h"
+
 __kernel void expand_wave_idxs(
-    int W, int H, int WF_SIZE,
-    __global const int *cost,
-    __global int *wf_prev_idxs,
+    int W, int H,
+    __global const uchar *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
     __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
     __global int *dist,
     int targetIdx,
     __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
 ) {
+    FIX_DIMS(W, H);
+    if (wave_overflowed(wf_prev_size, wf_next_size, WF_CAP))
+        return;
+
     int gidx = get_global_id(0);
-    if (gidx >= WF_SIZE)
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    // Steps queued after the target was found have nothing to do
+    if (*foundFlag)
         return;
 
     int idx = wf_prev_idxs[gidx];
 
     // Return if not in wavefront (-1)
-    if (idx < 0 || idx >= W*H)
+    if (idx < 0 || idx >= layout_cells(CELL_LAYOUT, W, H))
         return;
 
 
@@ -74,27 +112,466 @@ __kernel void expand_wave_idxs(
     
     // Get the distance set in the previous expansion
     int dcurr = dist[idx];
-    int x = idx % W;
-    int y = idx / W;
+    int moves = cell_moves(cells[idx]);
 
     // Check and add neighbors to next wavefront
     for (int k = 0; k < 4; k++) {
-        int nx = x + ((k==0)?-1: (k==1)?1:0);
-        int ny = y + ((k==2)?-1: (k==3)?1:0);
-        
-        if (nx < 0 || nx >= W || ny < 0 || ny >= H)
-            continue;
-        
-        int j = ny*W + nx;
-        
-        // Skip walls
-        if (cost[j] < 0)
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
             continue;
 
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
         // Check and add neighbors to next wavefront
         int old = atomic_cmpxchg(&dist[j], -1, dcurr + 1);
         if (old == -1) {
-            wf_next_idxs[4*gidx+k] = j;
+            wave_append(wf_next_idxs, wf_next_size, WF_CAP, j);
+        }
+    }
+}
+
+// Bottom-up step of the direction-optimizing BFS, launched over every cell.
+// The current wavefront is implicit: all cells at distance `level`, so an
+// unvisited cell joins the next wavefront if any neighbor is at that level.
+// No atomics are needed on dist since each thread only writes its own cell.
+__kernel void expand_wave_bottom_up(
+    int W, int H, int level,
+    __global const uchar *cells,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *dist,
+    int targetIdx,
+    __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
+) {
+    FIX_DIMS(W, H);
+    int idx = get_global_id(0);
+    if (idx >= layout_cells(CELL_LAYOUT, W, H))
+        return;
+
+    if (*foundFlag)
+        return;
+
+    int d = dist[idx];
+    if (idx == targetIdx && d == level) {
+        *foundFlag = 1;
+        return;
+    }
+
+    // Skip visited cells and walls
+    int c = cells[idx];
+    if (d != -1 || !(c & CELL_OPEN))
+        return;
+
+    // Look for a parent in the current wavefront
+    int moves = cell_moves(c);
+    for (int k = 0; k < 4; k++) {
+        if (!(moves & (1 << k)))
+            continue;
+
+        if (dist[layout_neighbor(CELL_LAYOUT, W, idx, k)] == level) {
+            dist[idx] = level + 1;
+            // The list is only used once the engine switches back to top-down
+            wave_append(wf_next_idxs, wf_next_size, WF_CAP, idx);
+            return;
+        }
+    }
+}
+
+// Bidirectional step, the first threads expand the forward wavefront (from the
+// start) and the rest the reverse wavefront (from the target) in one launch.
+// Both wavefronts are at distance `level` from their source. An edge into a
+// cell the other side already reached is a meeting candidate: meet[0] keeps
+// the first level with a candidate and meet[1 + t] one edge whose path has
+// length 2*level + t, encoded as forwardCell*4 + direction.
+__kernel void expand_wave_bidir(
+    int W, int H, int level,
+    __global const uchar *cells,
+    __global const int *fwd_prev_idxs,
+    __global const int *fwd_prev_size,
+    __global int *fwd_next_idxs,
+    __global int *fwd_next_size,
+    __global const int *rev_prev_idxs,
+    __global const int *rev_prev_size,
+    __global int *rev_next_idxs,
+    __global int *rev_next_size,
+    int WF_CAP,
+    __global int *dist_fwd,
+    __global int *dist_rev,
+    __global int *meet,
+    __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
+) {
+    FIX_DIMS(W, H);
+    // Both lists are rebuilt after either overflowed, see wave_overflowed
+    if (*fwd_prev_size > WF_CAP || *rev_prev_size > WF_CAP) {
+        if (get_global_id(0) == 0) {
+            *fwd_next_size = *fwd_prev_size;
+            *rev_next_size = *rev_prev_size;
+        }
+        return;
+    }
+
+    int gidx = get_global_id(0);
+    int nFwd = min(*fwd_prev_size, WF_CAP);
+    int nRev = min(*rev_prev_size, WF_CAP);
+    if (gidx >= nFwd + nRev)
+        return;
+
+    // Steps queued after the meeting level have nothing to do
+    if (meet[0] < level)
+        return;
+
+    bool forward = gidx < nFwd;
+    int idx = forward ? fwd_prev_idxs[gidx] : rev_prev_idxs[gidx - nFwd];
+    __global int *own = forward ? dist_fwd : dist_rev;
+    __global const int *other = forward ? dist_rev : dist_fwd;
+    __global int *next_idxs = forward ? fwd_next_idxs : rev_next_idxs;
+    __global int *next_size = forward ? fwd_next_size : rev_next_size;
+
+    int dcurr = own[idx];
+    int moves = cell_moves(cells[idx]);
+
+    for (int k = 0; k < 4; k++) {
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        // Candidates of the first meeting level are at most one step apart,
+        // any shorter path would have met a level earlier
+        int dOther = other[j];
+        if (dOther >= 0) {
+            int t = dcurr + 1 + dOther - 2*level;
+            if (t >= 0 && t < 3) {
+                // k^1 is the opposite direction
+                int edge = forward ? idx*4 + k : j*4 + (k^1);
+                atomic_min(&meet[0], level);
+                atomic_cmpxchg(&meet[1 + t], -1, edge);
+                *foundFlag = 1;
+            }
+            continue;
+        }
+
+        int old = atomic_cmpxchg(&own[j], -1, dcurr + 1);
+        if (old == -1) {
+            wave_append(next_idxs, next_size, WF_CAP, j);
+        }
+    }
+}
+
+// Multi-query step, every wavefront entry is tagged with its query as
+// q*N + idx and each query owns the distance slice dist[q*N, q*N + N).
+// A query stops expanding as soon as its target is reached.
+__kernel void expand_wave_batch(
+    int W, int H,
+    __global const uchar *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *dist,
+    __global const int *targets,
+    __global uchar *foundFlags
+) {
+    FIX_DIMS(W, H);
+    if (wave_overflowed(wf_prev_size, wf_next_size, WF_CAP))
+        return;
+
+    int gidx = get_global_id(0);
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    int N = layout_cells(CELL_LAYOUT, W, H);
+    int entry = wf_prev_idxs[gidx];
+    int q = entry / N;
+    int idx = entry - q*N;
+
+    if (foundFlags[q])
+        return;
+
+    __global int *qdist = dist + q*N;
+    int targetIdx = targets[q];
+    int dcurr = qdist[idx];
+    int moves = cell_moves(cells[idx]);
+
+    for (int k = 0; k < 4; k++) {
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int old = atomic_cmpxchg(&qdist[j], -1, dcurr + 1);
+        if (old == -1) {
+            // BFS distances are final when first written
+            if (j == targetIdx) {
+                foundFlags[q] = 1;
+                continue;
+            }
+            wave_append(wf_next_idxs, wf_next_size, WF_CAP, q*N + j);
+        }
+    }
+}
+
+// Lowers dist[j] to newDist, returns true if this call improved it.
+inline bool relax_dist(
+    __global int *dist,
+    int j,
+    int newDist
+) {
+    int oldDist = atomic_cmpxchg(&dist[j], -1, newDist);
+    if (oldDist == -1)
+        return true;
+
+    if (newDist < oldDist) {
+        int oldDist2 = atomic_min(&dist[j], newDist);
+        return newDist < oldDist2;
+    }
+    return false;
+}
+
+// Best known distance to the target, INT_MAX while it is unreached.
+inline int target_bound(
+    __global const int *dist,
+    int targetIdx
+) {
+    int d = dist[targetIdx];
+    return d < 0 ? INT_MAX : d;
+}
+
+// Manhattan distance from idx to the target, scaled by the cheapest step.
+inline int heuristic(
+    int W,
+    int idx,
+    int targetIdx,
+    int hWeight
+) {
+    int dx = abs(layout_x(CELL_LAYOUT, W, idx) - layout_x(CELL_LAYOUT, W, targetIdx));
+    int dy = abs(layout_y(CELL_LAYOUT, W, idx) - layout_y(CELL_LAYOUT, W, targetIdx));
+    return hWeight * (dx + dy);
+}
+
+// Puts `idx` into the far pile unless it is already there.
+inline void far_push(
+    __global int *far_idxs,
+    __global int *far_size,
+    int FAR_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int idx,
+    int f
+) {
+    atomic_min(far_min, f);
+    if (atomic_xchg(&far_flag[idx], 1) == 0)
+        wave_append(far_idxs, far_size, FAR_CAP, idx);
+}
+
+// A* step with unit costs, same arguments as the weighted expand_wave_astar.
+// Cells are bucketed by f = dist + h into near and far piles. A cell in a
+// later band can be reached before its shortest path is known, so unlike
+// the BFS kernels distances are relaxed and the search runs until no band
+// below the target distance is left.
+__kernel void expand_wave_astar(
+    int W, int H,
+    __global const uchar *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *far_idxs,
+    __global int *far_size,
+    int FAR_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int threshold,
+    __global int *dist,
+    int targetIdx,
+    __global uchar *foundFlag,  // OpenCL doesn’t allow pointers to host bool
+    int hWeight
+) {
+    FIX_DIMS(W, H);
+    int gidx = get_global_id(0);
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    int idx = wf_prev_idxs[gidx];
+
+    int bound = target_bound(dist, targetIdx);
+    int dcurr = dist[idx];
+    if (dcurr + heuristic(W, idx, targetIdx, hWeight) >= bound)
+        return;
+
+    int moves = cell_moves(cells[idx]);
+
+    for (int k = 0; k < 4; k++) {
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int f = dcurr + 1 + heuristic(W, j, targetIdx, hWeight);
+        if (f >= bound || !relax_dist(dist, j, dcurr + 1))
+            continue;
+
+        if (j == targetIdx) {
+            *foundFlag = 1;
+            continue;
+        }
+
+        if (f >= threshold ||
+            !wave_append(wf_next_idxs, wf_next_size, WF_CAP, j)) {
+            far_push(far_idxs, far_size, FAR_CAP, far_flag, far_min, j, f);
+        }
+    }
+}
+
+// Moves far pile cells whose f is below the new threshold into the near
+// wavefront and compacts the rest into far_out, collecting their smallest f.
+// Cells at or past the best target distance are dropped.
+__kernel void split_far_pile(
+    __global const int *far_in_idxs,
+    __global const int *far_in_size,
+    __global int *far_out_idxs,
+    __global int *far_out_size,
+    int FAR_CAP,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int threshold,
+    __global const int *dist,
+    int targetIdx,
+    int W,
+    int hWeight
+) {
+    int gidx = get_global_id(0);
+    if (gidx >= min(*far_in_size, FAR_CAP))
+        return;
+
+    int idx = far_in_idxs[gidx];
+    int f = dist[idx] + heuristic(W, idx, targetIdx, hWeight);
+
+    if (f >= target_bound(dist, targetIdx)) {
+        far_flag[idx] = 0;
+        return;
+    }
+
+    if (f < threshold) {
+        far_flag[idx] = 0;
+        if (wave_append(wf_next_idxs, wf_next_size, WF_CAP, idx))
+            return;
+        // Near list is full, keep the cell for the next split
+        far_flag[idx] = 1;
+    }
+
+    atomic_min(far_min, f);
+    wave_append(far_out_idxs, far_out_size, FAR_CAP, idx);
+}
+
+// Kernels shared with the weighted program, they take the cell type
+// and the cost of entering a cell from these
+#define CELL_T uchar
+// Unit steps whatever the cell costs are
+#define STEP_COST(c) 1
+#include "../shared/wavefront_kernels.h"
+
+// rebuild_frontier for expand_wave_batch, launched over every entry q*N + idx
+// of all distance slices. A reached cell of an unfinished query is queued if
+// expanding it can still lower a neighbor, the last level of that query.
+__kernel void rebuild_frontier_batch(
+    int W, int H,
+    __global const uchar *cells,
+    __global const int *dist,
+    __global int *wf_idxs,
+    __global int *wf_size,
+    int WF_CAP,
+    int Q,
+    __global const int *targets,
+    __global const uchar *foundFlags
+) {
+    FIX_DIMS(W, H);
+    int N = layout_cells(CELL_LAYOUT, W, H);
+    int entry = get_global_id(0);
+    if (entry >= Q*N)
+        return;
+
+    int q = entry / N;
+    int idx = entry - q*N;
+    __global const int *qdist = dist + q*N;
+    int d = qdist[idx];
+    int c = cells[idx];
+
+    // Queries that reached their target are done
+    if (foundFlags[q] || d < 0 || !(c & CELL_OPEN))
+        return;
+
+    bool queued = false;
+    int moves = cell_moves(c);
+    for (int k = 0; k < 4 && !queued; k++) {
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+        int dn = qdist[j];
+        queued = dn < 0 || d + 1 < dn;
+    }
+
+    if (queued)
+        wave_append(wf_idxs, wf_size, WF_CAP, entry);
+}
+
+// Label-correcting expansion for repairs, where distances of reached cells
+// can still drop. Like the weighted expand_wave_idxs it only stops once
+// nothing is queued below the target distance.
+__kernel void relax_wave_idxs(
+    int W, int H,
+    __global const uchar *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *dist,
+    int targetIdx,
+    __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
+) {
+    FIX_DIMS(W, H);
+    if (wave_overflowed(wf_prev_size, wf_next_size, WF_CAP))
+        return;
+
+    int gidx = get_global_id(0);
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    int idx = wf_prev_idxs[gidx];
+    if (idx < 0 || idx >= layout_cells(CELL_LAYOUT, W, H))
+        return;
+
+    int bound = target_bound(dist, targetIdx);
+    int dcurr = dist[idx];
+    if (dcurr < 0 || dcurr >= bound)
+        return;
+
+    int moves = cell_moves(cells[idx]);
+    for (int k = 0; k < 4; k++) {
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+        int newDist = dcurr + 1;
+        if (newDist >= bound || !relax_dist(dist, j, newDist))
+            continue;
+
+        // The target is never expanded, its neighbors would be past the bound
+        if (j == targetIdx) {
+            *foundFlag = 1;
+            continue;
         }
+        wave_append(wf_next_idxs, wf_next_size, WF_CAP, j);
     }
 }
@@ -1,14 +1,51 @@
+// Cells are encoded on the host by Maze::encodeCells: bit k is set if the
+// move in direction k (left, right, up, down) stays inside the maze and
+// enters an open cell, CELL_OPEN marks the open cells themselves. The weighted
+// program takes two bytes per cell with the cost in the high byte.
+#define CELL_OPEN 0x10
+
+inline int cell_moves(ushort c) {
+    return c & 0xF;
+}
+
+// Cost of entering the cell.
+inline int cell_cost(ushort c) {
+    return c >> 8;
+}
+
+// Cell layout of the grids, the host selects it with -DCELL_LAYOUT
+#include "../shared/cell_layout.h"
+#ifndef CELL_LAYOUT
+#define CELL_LAYOUT LAYOUT_ROW_MAJOR
+#endif
+
+// Variants specialized for one maze get its size with -DMAZE_W and -DMAZE_H,
+// see Maze::kernelOptions. Kernels taking W and H start with FIX_DIMS so the
+// index arithmetic folds into constants and the size arguments are ignored.
+#if defined(MAZE_W) && defined(MAZE_H)
+#define FIX_DIMS(W, H) W = MAZE_W; H = MAZE_H
+#else
+#define FIX_DIMS(W, H)
+#endif
+
+// Index of the neighbor in direction k in a row-major grid of width W, only
+// used for the local tile arrays, global grids go through layout_neighbor.
+inline int neighbor_idx(int W, int idx, int k) {
+    return idx + ((k==0)?-1: (k==1)?1: (k==2)?-W:W);
+}
+
 __kernel void expand_wave_naive(
     int W, int H,
-    __global const int *cost,
+    __global const ushort *cells,
     __global uchar *wf_prev,
     __global uchar *wf_next,
     __global int *dist,
     int targetIdx,
     __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
 ) {
+    FIX_DIMS(W, H);
     int idx = get_global_id(0);
-    if (idx >= W*H)
+    if (idx >= layout_cells(CELL_LAYOUT, W, H))
         return;
     
     // Return if not in wavefront
@@ -22,24 +59,17 @@ __kernel void expand_wave_naive(
 
     // Get the distance set in the previous expansion
     int dcurr = dist[idx];
-    int x = idx % W;
-    int y = idx / W;
+    int moves = cell_moves(cells[idx]);
 
     // Check and add neighbors to next wavefront
     for (int k = 0; k < 4; k++) {
-        int nx = x + ((k==0)?-1: (k==1)?1:0);
-        int ny = y + ((k==2)?-1: (k==3)?1:0);
-        
-        if (nx < 0 || nx >= W || ny < 0 || ny >= H)
-            continue;
-        
-        int j = ny*W + nx;
-        
-        // Skip walls
-        if (cost[j] < 0)
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
             continue;
 
-        int newDist = dcurr + cost[j];
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int newDist = dcurr + cell_cost(cells[j]);
         
         // Handle initialization from -1
         int oldDist = atomic_cmpxchg(&dist[j], -1, newDist);
@@ -59,63 +89,398 @@ __kernel void expand_wave_naive(
     }
 }
 
+// Compacted wavefront lists
+#include "../shared/wave_list.h"
+
+// Lowers dist[j] to newDist, returns true if this call improved it.
+inline bool relax_dist(
+    __global int *dist,
+    int j,
+    int newDist
+) {
+    // Handle initialization from -1
+    int oldDist = atomic_cmpxchg(&dist[j], -1, newDist);
+    if (oldDist == -1)
+        return true;
+
+    // NOTE: only try to write if it is smaller
+    if (newDist < oldDist) {
+        int oldDist2 = atomic_min(&dist[j], newDist);
+        return newDist < oldDist2;
+    }
+    return false;
+}
+
+// Best known distance to the target, INT_MAX while it is unreached.
+// Positive costs make any cell at or past it useless for the path.
+inline int target_bound(
+    __global const int *dist,
+    int targetIdx
+) {
+    int d = dist[targetIdx];
+    return d < 0 ? INT_MAX : d;
+}
+
 __kernel void expand_wave_idxs(
-    int W, int H, int WF_SIZE,
-    __global const int *cost,
-    __global int *wf_prev_idxs,
+    int W, int H,
+    __global const ushort *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
     __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
     __global int *dist,
     int targetIdx,
     __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
 ) {
+    FIX_DIMS(W, H);
+    if (wave_overflowed(wf_prev_size, wf_next_size, WF_CAP))
+        return;
+
     int gidx = get_global_id(0);
-    if (gidx >= WF_SIZE)
+    if (gidx >= min(*wf_prev_size, WF_CAP))
         return;
 
     int idx = wf_prev_idxs[gidx];
 
     // Return if not in wavefront (-1)
-    if (idx < 0 || idx >= W*H)
+    if (idx < 0 || idx >= layout_cells(CELL_LAYOUT, W, H))
         return;
 
+    // Get the distance set in the previous expansion,
+    // cells at or past the best target distance cannot improve it
+    int bound = target_bound(dist, targetIdx);
+    int dcurr = dist[idx];
+    if (dcurr >= bound)
+        return;
 
-    if (idx == targetIdx) {
-        *foundFlag = 1;
+    int moves = cell_moves(cells[idx]);
+
+    // Check and add neighbors to next wavefront
+    for (int k = 0; k < 4; k++) {
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int newDist = dcurr + cell_cost(cells[j]);
+        if (newDist >= bound)
+            continue;
+
+        if (relax_dist(dist, j, newDist)) {
+            // The target is never expanded, its neighbors would be past the bound
+            if (j == targetIdx) {
+                *foundFlag = 1;
+                continue;
+            }
+            wave_append(wf_next_idxs, wf_next_size, WF_CAP, j);
+        }
+    }
+}
+
+// Puts `idx` into the far pile unless it is already there. far_flag holds one
+// int per cell and is cleared when the cell leaves the pile.
+inline void far_push(
+    __global int *far_idxs,
+    __global int *far_size,
+    int FAR_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int idx,
+    int d
+) {
+    atomic_min(far_min, d);
+    if (atomic_xchg(&far_flag[idx], 1) == 0)
+        wave_append(far_idxs, far_size, FAR_CAP, idx);
+}
+
+// Delta-stepping relaxation with near-far piles: improved cells below the
+// bucket threshold go to the next (near) wavefront, the rest is deferred to
+// the far pile until the host advances the threshold. Cells that do not fit
+// into the near list spill into the far pile so they are never lost.
+__kernel void expand_wave_near_far(
+    int W, int H,
+    __global const ushort *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *far_idxs,
+    __global int *far_size,
+    int FAR_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int threshold,
+    __global int *dist,
+    int targetIdx,
+    __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
+) {
+    FIX_DIMS(W, H);
+    int gidx = get_global_id(0);
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    int idx = wf_prev_idxs[gidx];
+
+    int bound = target_bound(dist, targetIdx);
+    int dcurr = dist[idx];
+    if (dcurr >= bound)
         return;
+
+    int moves = cell_moves(cells[idx]);
+
+    for (int k = 0; k < 4; k++) {
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int newDist = dcurr + cell_cost(cells[j]);
+        if (newDist >= bound || !relax_dist(dist, j, newDist))
+            continue;
+
+        if (j == targetIdx) {
+            *foundFlag = 1;
+            continue;
+        }
+
+        if (newDist >= threshold ||
+            !wave_append(wf_next_idxs, wf_next_size, WF_CAP, j)) {
+            far_push(far_idxs, far_size, FAR_CAP, far_flag, far_min, j, newDist);
+        }
     }
-    
-    // Get the distance set in the previous expansion
+}
+
+// Admissible distance estimate from idx to the target: every step enters a
+// cell that costs at least hWeight.
+inline int heuristic(
+    int W,
+    int idx,
+    int targetIdx,
+    int hWeight
+) {
+    int dx = abs(layout_x(CELL_LAYOUT, W, idx) - layout_x(CELL_LAYOUT, W, targetIdx));
+    int dy = abs(layout_y(CELL_LAYOUT, W, idx) - layout_y(CELL_LAYOUT, W, targetIdx));
+    return hWeight * (dx + dy);
+}
+
+// A* step on top of the near-far piles: cells are bucketed by f = dist + h
+// instead of dist, so the near wavefront only holds the band of cells that
+// currently look closest to the target. Cells whose f reaches the best
+// target distance can not lie on a shorter path and are dropped.
+__kernel void expand_wave_astar(
+    int W, int H,
+    __global const ushort *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *far_idxs,
+    __global int *far_size,
+    int FAR_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int threshold,
+    __global int *dist,
+    int targetIdx,
+    __global uchar *foundFlag,  // OpenCL doesn’t allow pointers to host bool
+    int hWeight
+) {
+    FIX_DIMS(W, H);
+    int gidx = get_global_id(0);
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    int idx = wf_prev_idxs[gidx];
+
+    int bound = target_bound(dist, targetIdx);
     int dcurr = dist[idx];
-    int x = idx % W;
-    int y = idx / W;
+    if (dcurr + heuristic(W, idx, targetIdx, hWeight) >= bound)
+        return;
+
+    int moves = cell_moves(cells[idx]);
 
-    // Check and add neighbors to next wavefront
     for (int k = 0; k < 4; k++) {
-        int nx = x + ((k==0)?-1: (k==1)?1:0);
-        int ny = y + ((k==2)?-1: (k==3)?1:0);
-        
-        if (nx < 0 || nx >= W || ny < 0 || ny >= H)
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
             continue;
-        
-        int j = ny*W + nx;
-        
-        // Skip walls
-        if (cost[j] < 0)
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int newDist = dcurr + cell_cost(cells[j]);
+        int f = newDist + heuristic(W, j, targetIdx, hWeight);
+        if (f >= bound || !relax_dist(dist, j, newDist))
+            continue;
+
+        if (j == targetIdx) {
+            *foundFlag = 1;
             continue;
+        }
 
-        int newDist = dcurr + cost[j];
+        if (f >= threshold ||
+            !wave_append(wf_next_idxs, wf_next_size, WF_CAP, j)) {
+            far_push(far_idxs, far_size, FAR_CAP, far_flag, far_min, j, f);
+        }
+    }
+}
 
-        // Handle initialization from -1
-        int oldDist = atomic_cmpxchg(&dist[j], -1, newDist);
+// Moves far pile cells below the new threshold into the near wavefront and
+// compacts the rest into far_out, collecting their smallest key. The key is
+// dist + h, which is just dist for delta-stepping where hWeight is 0.
+// Cells at or past the best target distance are dropped.
+__kernel void split_far_pile(
+    __global const int *far_in_idxs,
+    __global const int *far_in_size,
+    __global int *far_out_idxs,
+    __global int *far_out_size,
+    int FAR_CAP,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *far_flag,
+    __global int *far_min,
+    int threshold,
+    __global const int *dist,
+    int targetIdx,
+    int W,
+    int hWeight
+) {
+    int gidx = get_global_id(0);
+    if (gidx >= min(*far_in_size, FAR_CAP))
+        return;
 
-        if (oldDist == -1) {
-            wf_next_idxs[4*gidx+k] = j;
-        } else
-        if (newDist < oldDist) {
-            int oldDist2 = atomic_min(&dist[j], newDist);
-            if (newDist < oldDist2) {
-                wf_next_idxs[4*gidx+k] = j;
-            }
+    int idx = far_in_idxs[gidx];
+    int f = dist[idx] + heuristic(W, idx, targetIdx, hWeight);
+
+    if (f >= target_bound(dist, targetIdx)) {
+        far_flag[idx] = 0;
+        return;
+    }
+
+    if (f < threshold) {
+        far_flag[idx] = 0;
+        if (wave_append(wf_next_idxs, wf_next_size, WF_CAP, idx))
+            return;
+        // Near list is full, keep the cell for the next split
+        far_flag[idx] = 1;
+    }
+
+    atomic_min(far_min, f);
+    wave_append(far_out_idxs, far_out_size, FAR_CAP, idx);
+}
+
+// Multi-query step, every wavefront entry is tagged with its query as
+// q*N + idx and each query owns the distance slice dist[q*N, q*N + N).
+// Each query is pruned by its own target distance like expand_wave_idxs,
+// a target of -1 never prunes.
+__kernel void expand_wave_batch(
+    int W, int H,
+    __global const ushort *cells,
+    __global const int *wf_prev_idxs,
+    __global const int *wf_prev_size,
+    __global int *wf_next_idxs,
+    __global int *wf_next_size,
+    int WF_CAP,
+    __global int *dist,
+    __global const int *targets,
+    __global uchar *foundFlags
+) {
+    FIX_DIMS(W, H);
+    if (wave_overflowed(wf_prev_size, wf_next_size, WF_CAP))
+        return;
+
+    int gidx = get_global_id(0);
+    if (gidx >= min(*wf_prev_size, WF_CAP))
+        return;
+
+    int N = layout_cells(CELL_LAYOUT, W, H);
+    int entry = wf_prev_idxs[gidx];
+    int q = entry / N;
+    int idx = entry - q*N;
+
+    __global int *qdist = dist + q*N;
+    int targetIdx = targets[q];
+    // Queries without a target compute the whole distance field
+    int bound = targetIdx < 0 ? INT_MAX : target_bound(qdist, targetIdx);
+    int dcurr = qdist[idx];
+    if (dcurr >= bound)
+        return;
+
+    int moves = cell_moves(cells[idx]);
+
+    for (int k = 0; k < 4; k++) {
+        // Walls and the maze border are not in the moves
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+
+        int newDist = dcurr + cell_cost(cells[j]);
+        if (newDist >= bound || !relax_dist(qdist, j, newDist))
+            continue;
+
+        if (j == targetIdx) {
+            foundFlags[q] = 1;
+            continue;
         }
+        wave_append(wf_next_idxs, wf_next_size, WF_CAP, q*N + j);
     }
 }
+
+// Kernels shared with the uniform program, they take the cell type
+// and the cost of entering a cell from these
+#define CELL_T ushort
+// Entering a cell costs its own cost
+#define STEP_COST(c) cell_cost(c)
+#include "../shared/wavefront_kernels.h"
+
+// rebuild_frontier for expand_wave_batch, launched over every entry q*N + idx
+// of all distance slices. A reached cell of a query is queued if expanding
+// it can still lower a neighbor below the target distance of the query.
+__kernel void rebuild_frontier_batch(
+    int W, int H,
+    __global const ushort *cells,
+    __global const int *dist,
+    __global int *wf_idxs,
+    __global int *wf_size,
+    int WF_CAP,
+    int Q,
+    __global const int *targets,
+    __global const uchar *foundFlags
+) {
+    FIX_DIMS(W, H);
+    int N = layout_cells(CELL_LAYOUT, W, H);
+    int entry = get_global_id(0);
+    if (entry >= Q*N)
+        return;
+
+    int q = entry / N;
+    int idx = entry - q*N;
+    __global const int *qdist = dist + q*N;
+    int d = qdist[idx];
+    int c = cells[idx];
+
+    // Cells at or past the target distance are pruned by expand_wave_batch
+    int targetIdx = targets[q];
+    int bound = targetIdx < 0 ? INT_MAX : target_bound(qdist, targetIdx);
+    if (d < 0 || d >= bound || !(c & CELL_OPEN))
+        return;
+
+    bool queued = false;
+    int moves = cell_moves(c);
+    for (int k = 0; k < 4 && !queued; k++) {
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+        int dn = qdist[j];
+        queued = dn < 0 || d + cell_cost(cells[j]) < dn;
+    }
+
+    if (queued)
+        wave_append(wf_idxs, wf_size, WF_CAP, entry);
+}
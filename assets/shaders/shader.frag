@@ -1,13 +1,18 @@
 #version 450 core
+#include "../shared/cell_layout.h"
 in vec2 fragUV;
 out vec4 outColor;
 
+// All buffers are in the cell layout of the kernels, see cell_layout.h
+
+// Encoded cells, one byte per cell packed four per word (Maze::encodeCells)
 layout(std430, binding = 0) buffer MyBuffer1 {
-    int data_wall[];
+    uint data_cells[];
 };
 
+// 16 bit distances packed two per word, 0xFFFF for unreached cells
 layout(std430, binding = 1) buffer MyBuffer2 {
-    int data_dist[];
+    uint data_dist[];
 };
 
 layout(std430, binding = 2) buffer MyBuffer3 {
@@ -17,27 +22,32 @@ layout(std430, binding = 2) buffer MyBuffer3 {
 uniform int imageWidth;
 uniform int imageHeight;
 uniform int maxDist;
+uniform int cellLayout;
+
+const uint CELL_OPEN = 0x10u;
 
 void main() {
     int x = int(fragUV.x * imageWidth);
     int y = int(fragUV.y * imageHeight);
-    int idx = y * imageWidth + x;
-
-    if (idx >= imageWidth * imageHeight) discard;
+    if (x >= imageWidth || y >= imageHeight) discard;
+    int idx = layout_index(cellLayout, imageWidth, x, y);
 
     if (data_visit[idx] == 2) { // marked path
         outColor = vec4(0.0, 1.0, 0.0, 0.8);
         return;
     }
 
-    if (data_wall[idx] < 0) { // wall
+    uint cell = (data_cells[idx >> 2] >> (8 * (idx & 3))) & 0xFFu;
+    if ((cell & CELL_OPEN) == 0u) { // wall
         outColor = vec4(0.0, 0.0, 0.0, 1.0);
         return;
     }
 
     {
         // Normalize distance to [0, 1] range — adjust scale as needed
-        float t = clamp(float(data_dist[idx]) / float(maxDist), 0.0, 1.0);
+        uint d = (data_dist[idx >> 1] >> (16 * (idx & 1))) & 0xFFFFu;
+        float dist = (d == 0xFFFFu) ? -1.0 : float(d);
+        float t = clamp(dist / float(maxDist), 0.0, 1.0);
 
         vec3 colorA = vec3(0.2, 0.4, 1.0); // near
         vec3 colorB = vec3(1.0, 0.4, 0.2); // far
@@ -0,0 +1,90 @@
+// Cell layout of the device grids, shared by the OpenCL kernels, shader.frag
+// and the host so that all of them agree on where a cell is stored. The
+// kernels and the shader pull it in through Utils::readSourceFile.
+//
+// LAYOUT_ROW_MAJOR stores cell (x, y) at y*W + x, vertical neighbors are a
+// whole row apart. LAYOUT_BLOCKED stores the grid in 8x8 blocks, row-major
+// inside a block and block by block, so most horizontal and vertical
+// neighbors share a block. Blocked grids are padded to whole blocks, the
+// padding cells are walls. The mode parameters are named so because layout is
+// a GLSL keyword.
+#ifndef CELL_LAYOUT_H
+#define CELL_LAYOUT_H
+
+#if defined(__cplusplus) || defined(__OPENCL_VERSION__)
+#define LAYOUT_FN inline
+#else
+#define LAYOUT_FN
+#endif
+
+#define LAYOUT_ROW_MAJOR 0
+#define LAYOUT_BLOCKED 1
+#define LAYOUT_BLOCK_SHIFT 3
+#define LAYOUT_BLOCK_MASK 7
+
+// Blocks per row of a blocked grid
+LAYOUT_FN int layout_blocks(int n)
+{
+    return (n + LAYOUT_BLOCK_MASK) >> LAYOUT_BLOCK_SHIFT;
+}
+
+// Number of stored cells of a W x H grid
+LAYOUT_FN int layout_cells(int mode, int W, int H)
+{
+    if (mode == LAYOUT_BLOCKED)
+        return (layout_blocks(W) * layout_blocks(H)) << (2 * LAYOUT_BLOCK_SHIFT);
+    return W * H;
+}
+
+// Storage index of cell (x, y)
+LAYOUT_FN int layout_index(int mode, int W, int x, int y)
+{
+    if (mode == LAYOUT_BLOCKED) {
+        int block = (y >> LAYOUT_BLOCK_SHIFT) * layout_blocks(W) + (x >> LAYOUT_BLOCK_SHIFT);
+        return (block << (2 * LAYOUT_BLOCK_SHIFT))
+            | ((y & LAYOUT_BLOCK_MASK) << LAYOUT_BLOCK_SHIFT)
+            | (x & LAYOUT_BLOCK_MASK);
+    }
+    return y * W + x;
+}
+
+// Column of the cell stored at index i
+LAYOUT_FN int layout_x(int mode, int W, int i)
+{
+    if (mode == LAYOUT_BLOCKED) {
+        int block = i >> (2 * LAYOUT_BLOCK_SHIFT);
+        return ((block % layout_blocks(W)) << LAYOUT_BLOCK_SHIFT) | (i & LAYOUT_BLOCK_MASK);
+    }
+    return i % W;
+}
+
+// Row of the cell stored at index i
+LAYOUT_FN int layout_y(int mode, int W, int i)
+{
+    if (mode == LAYOUT_BLOCKED) {
+        int block = i >> (2 * LAYOUT_BLOCK_SHIFT);
+        return ((block / layout_blocks(W)) << LAYOUT_BLOCK_SHIFT) | ((i >> LAYOUT_BLOCK_SHIFT) & LAYOUT_BLOCK_MASK);
+    }
+    return i / W;
+}
+
+// Storage index of the neighbor of the cell stored at index i in direction k
+// (left, right, up, down). The neighbor has to be inside the grid. Moves
+// inside a block stay a fixed offset apart, only moves across a block border
+// jump to the next block.
+LAYOUT_FN int layout_neighbor(int mode, int W, int i, int k)
+{
+    if (mode == LAYOUT_BLOCKED) {
+        int blockCells = 1 << (2 * LAYOUT_BLOCK_SHIFT);
+        int rowCells = layout_blocks(W) * blockCells;
+        int bx = i & LAYOUT_BLOCK_MASK;
+        int by = (i >> LAYOUT_BLOCK_SHIFT) & LAYOUT_BLOCK_MASK;
+        if (k == 0) return bx > 0 ? i - 1 : i - blockCells + LAYOUT_BLOCK_MASK;
+        if (k == 1) return bx < LAYOUT_BLOCK_MASK ? i + 1 : i + blockCells - LAYOUT_BLOCK_MASK;
+        if (k == 2) return by > 0 ? i - (1 << LAYOUT_BLOCK_SHIFT) : i - rowCells + (LAYOUT_BLOCK_MASK << LAYOUT_BLOCK_SHIFT);
+        return by < LAYOUT_BLOCK_MASK ? i + (1 << LAYOUT_BLOCK_SHIFT) : i + rowCells - (LAYOUT_BLOCK_MASK << LAYOUT_BLOCK_SHIFT);
+    }
+    return i + ((k == 0) ? -1 : (k == 1) ? 1 : (k == 2) ? -W : W);
+}
+
+#endif // CELL_LAYOUT_H
@@ -0,0 +1,38 @@
+// Compacted wavefront lists of the OpenCL kernels, included by both kernel
+// programs through Utils::readSourceFile. A list is an index array with an
+// atomic counter next to it and a capacity WF_CAP passed by the host.
+#ifndef WAVE_LIST_H
+#define WAVE_LIST_H
+
+// Appends `idx` to a compacted wavefront list, the counter keeps growing past
+// WF_CAP so the host can tell that the list overflowed.
+inline bool wave_append(
+    __global int *wf_idxs,
+    __global int *wf_size,
+    int WF_CAP,
+    int idx
+) {
+    int slot = atomic_inc(wf_size);
+    if (slot >= WF_CAP)
+        return false;
+    wf_idxs[slot] = idx;
+    return true;
+}
+
+// A list that overflowed has lost entries. The steps queued after it pass its
+// size on and do nothing until the host rebuilds the frontier at the next
+// sync point, see rebuild_frontier.
+inline bool wave_overflowed(
+    __global const int *wf_prev_size,
+    __global int *wf_next_size,
+    int WF_CAP
+) {
+    int n = *wf_prev_size;
+    if (n <= WF_CAP)
+        return false;
+    if (get_global_id(0) == 0)
+        *wf_next_size = n;
+    return true;
+}
+
+#endif
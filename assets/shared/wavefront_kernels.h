@@ -0,0 +1,317 @@
+// Kernels shared by the uniform and the weighted program, included through
+// Utils::readSourceFile. The including program defines CELL_T, the type of
+// a cell, and STEP_COST(c), the cost of entering cell c, along with
+// cell_moves, target_bound and the wave lists (wave_list.h) they build on.
+#ifndef WAVEFRONT_KERNELS_H
+#define WAVEFRONT_KERNELS_H
+
+// Side length of the square tiles of expand_tiles, the host launches
+// work-groups of TILE*TILE work-items (MazeState::tileSize)
+#define TILE 16
+#define TILE_HALO (TILE + 2)
+
+// Queues tile t for the next launch unless its flag shows it already is.
+inline void tile_activate(
+    __global int *tile_flag,
+    __global int *tiles_next,
+    __global int *tiles_next_size,
+    int TILE_CAP,
+    int t
+) {
+    if (atomic_xchg(&tile_flag[t], 1) == 0)
+        wave_append(tiles_next, tiles_next_size, TILE_CAP, t);
+}
+
+// Tiled relaxation, one work-group per active tile. The distances of the tile
+// and a one cell halo are loaded into local memory and relaxed there until nothing changes,
+// so a launch covers many wavefront levels with a single pass over global
+// memory. Only improved cells are written back, and a tile whose border
+// improved wakes the neighbor on that side. Cells of a tile are only written
+// by its own work-group, distances can still drop later when a neighbor
+// improves, so the search runs until no tile is active.
+__kernel void expand_tiles(
+    int W, int H,
+    __global const CELL_T *cells,
+    __global const int *tiles_prev,
+    __global const int *tiles_prev_size,
+    __global int *tiles_next,
+    __global int *tiles_next_size,
+    int TILE_CAP,
+    __global int *tile_flag,
+    __global int *dist,
+    int targetIdx,
+    __global uchar *foundFlag   // OpenCL doesn’t allow pointers to host bool
+) {
+    FIX_DIMS(W, H);
+    __local int ldist[TILE_HALO*TILE_HALO];
+    __local int changed[2];
+    __local int sides;
+
+    // The whole work-group returns together, before any barrier
+    int group = get_group_id(0);
+    if (group >= min(*tiles_prev_size, TILE_CAP))
+        return;
+
+    int t = tiles_prev[group];
+    int lid = get_local_id(0);
+    int tilesX = (W + TILE - 1) / TILE;
+    int x0 = (t % tilesX) * TILE;
+    int y0 = (t / tilesX) * TILE;
+
+    // Clear the flag before reading the halo, a neighbor improving it from
+    // now on queues this tile again
+    if (lid == 0) {
+        atomic_xchg(&tile_flag[t], 0);
+        changed[0] = 0;
+        changed[1] = 0;
+        sides = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+
+    // Halo cells outside the maze are never read, the moves exclude them
+    for (int i = lid; i < TILE_HALO*TILE_HALO; i += TILE*TILE) {
+        int gx = x0 + i % TILE_HALO - 1;
+        int gy = y0 + i / TILE_HALO - 1;
+        bool inside = gx >= 0 && gx < W && gy >= 0 && gy < H;
+        ldist[i] = inside ? dist[layout_index(CELL_LAYOUT, W, gx, gy)] : -1;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int lx = lid % TILE;
+    int ly = lid / TILE;
+    int l = (ly + 1)*TILE_HALO + lx + 1;
+    int idx = layout_index(CELL_LAYOUT, W, x0 + lx, y0 + ly);
+    int c = (x0 + lx < W && y0 + ly < H) ? cells[idx] : 0;
+    bool own = (c & CELL_OPEN) != 0;
+    int moves = cell_moves(c);
+    int dstart = ldist[l];
+
+    // Cells at or past the best target distance cannot improve it, a target
+    // inside the tile tightens the bound while the tile converges
+    int bound = target_bound(dist, targetIdx);
+    int tx = layout_x(CELL_LAYOUT, W, targetIdx) - x0;
+    int ty = layout_y(CELL_LAYOUT, W, targetIdx) - y0;
+    int lt = (tx >= 0 && tx < TILE && ty >= 0 && ty < TILE) ? (ty + 1)*TILE_HALO + tx + 1 : -1;
+
+    // A path can wind through every cell of the tile, past that the tile
+    // queues itself again instead of stalling the launch
+    bool converged = false;
+    for (int iter = 0; iter < TILE*TILE; iter++) {
+        int slot = iter & 1;
+        int b = bound;
+        if (lt >= 0 && ldist[lt] >= 0)
+            b = min(b, ldist[lt]);
+
+        int best = own ? ldist[l] : -1;
+        if (own) {
+            for (int k = 0; k < 4; k++) {
+                if (!(moves & (1 << k)))
+                    continue;
+                int dn = ldist[neighbor_idx(TILE_HALO, l, k)];
+                if (dn < 0)
+                    continue;
+                int newDist = dn + STEP_COST(c);
+                if (newDist < b && (best < 0 || newDist < best))
+                    best = newDist;
+            }
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (own && best != ldist[l]) {
+            ldist[l] = best;
+            changed[slot] = 1;
+        }
+        // Nobody reads the other slot until the next barrier
+        if (lid == 0)
+            changed[slot ^ 1] = 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (!changed[slot]) {
+            converged = true;
+            break;
+        }
+    }
+
+    if (own && ldist[l] != dstart) {
+        dist[idx] = ldist[l];
+        if (idx == targetIdx)
+            *foundFlag = 1;
+
+        // Border cells with a move across wake that neighbor
+        int side = 0;
+        if (lx == 0)        side |= moves & 1;
+        if (lx == TILE - 1) side |= moves & 2;
+        if (ly == 0)        side |= moves & 4;
+        if (ly == TILE - 1) side |= moves & 8;
+        if (side)
+            atomic_or(&sides, side);
+    }
+    mem_fence(CLK_GLOBAL_MEM_FENCE);
+    barrier(CLK_LOCAL_MEM_FENCE | CLK_GLOBAL_MEM_FENCE);
+
+    if (lid == 0) {
+        if (sides & 1) tile_activate(tile_flag, tiles_next, tiles_next_size, TILE_CAP, t - 1);
+        if (sides & 2) tile_activate(tile_flag, tiles_next, tiles_next_size, TILE_CAP, t + 1);
+        if (sides & 4) tile_activate(tile_flag, tiles_next, tiles_next_size, TILE_CAP, t - tilesX);
+        if (sides & 8) tile_activate(tile_flag, tiles_next, tiles_next_size, TILE_CAP, t + tilesX);
+        if (!converged)
+            tile_activate(tile_flag, tiles_next, tiles_next_size, TILE_CAP, t);
+    }
+}
+
+// 16 bit copy of the distances for the renderer, saturated at 0xFFFE with
+// 0xFFFF for unreached cells. Halves the per-frame readback.
+__kernel void narrow_distances(
+    int N,
+    __global const int *dist,
+    __global ushort *dist16
+) {
+    int idx = get_global_id(0);
+    if (idx >= N)
+        return;
+
+    int d = dist[idx];
+    dist16[idx] = d < 0 ? 0xFFFF : (ushort)min(d, 0xFFFE);
+}
+
+// Refills a wavefront list after an overflow lost entries, launched over
+// every cell. A reached cell is queued if expanding it can still lower a
+// neighbor, and the target is queued so the next step finds it. In a
+// level-synchronous run these are the cells of the last level, their
+// distance is collected in max_level.
+__kernel void rebuild_frontier(
+    int W, int H,
+    __global const CELL_T *cells,
+    __global const int *dist,
+    __global int *wf_idxs,
+    __global int *wf_size,
+    int WF_CAP,
+    int targetIdx,
+    __global int *max_level
+) {
+    FIX_DIMS(W, H);
+    int idx = get_global_id(0);
+    if (idx >= layout_cells(CELL_LAYOUT, W, H))
+        return;
+
+    int d = dist[idx];
+    int c = cells[idx];
+    if (d < 0 || !(c & CELL_OPEN))
+        return;
+
+    bool queued = idx == targetIdx;
+    int moves = cell_moves(c);
+    for (int k = 0; k < 4 && !queued; k++) {
+        if (!(moves & (1 << k)))
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+        int dn = dist[j];
+        queued = dn < 0 || d + STEP_COST(cells[j]) < dn;
+    }
+
+    if (queued) {
+        atomic_max(max_level, d);
+        wave_append(wf_idxs, wf_size, WF_CAP, idx);
+    }
+}
+
+// Incremental repair after cells changed, see Maze::repairDistances. An
+// invalidated cell holds -2 - d with d the distance it had, -1 keeps meaning
+// unreached.
+#define INVALID_DIST(d) (-2 - (d))
+
+// Invalidates the neighbors that may have been reached through the listed
+// cells: a neighbor whose distance is the old distance of the listed cell
+// plus its step cost. Walls that used to be open are still listed, so the
+// neighbors are found by position instead of by moves. Newly invalidated
+// cells are appended to the list, the host launches again for them.
+__kernel void invalidate_distances(
+    int W, int H,
+    __global const CELL_T *cells,
+    __global int *list,
+    int begin,
+    int count,
+    __global int *list_size,
+    int LIST_CAP,
+    __global int *dist
+) {
+    FIX_DIMS(W, H);
+    int gidx = get_global_id(0);
+    if (gidx >= count)
+        return;
+
+    int idx = list[begin + gidx];
+    int dold = INVALID_DIST(dist[idx]);
+    int x = layout_x(CELL_LAYOUT, W, idx);
+    int y = layout_y(CELL_LAYOUT, W, idx);
+
+    for (int k = 0; k < 4; k++) {
+        bool inside = (k == 0) ? x > 0 : (k == 1) ? x < W - 1 : (k == 2) ? y > 0 : y < H - 1;
+        if (!inside)
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+        CELL_T c = cells[j];
+        int dj = dist[j];
+        if (!(c & CELL_OPEN) || dj < 0 || dj != dold + STEP_COST(c))
+            continue;
+
+        // Only one of the listed neighbors appends it
+        if (atomic_cmpxchg(&dist[j], dj, INVALID_DIST(dj)) == dj)
+            wave_append(list, list_size, LIST_CAP, j);
+    }
+}
+
+// Resets the invalidated cells to unreached and queues their reached
+// neighbors, relaxing from these refills the invalidated region. A neighbor
+// next to several invalidated cells is queued more than once.
+__kernel void seed_repair(
+    int W, int H,
+    __global const int *list,
+    int count,
+    __global int *wf_idxs,
+    __global int *wf_size,
+    int WF_CAP,
+    __global int *dist
+) {
+    FIX_DIMS(W, H);
+    int gidx = get_global_id(0);
+    if (gidx >= count)
+        return;
+
+    int idx = list[gidx];
+    dist[idx] = -1;
+    int x = layout_x(CELL_LAYOUT, W, idx);
+    int y = layout_y(CELL_LAYOUT, W, idx);
+
+    // Invalidated neighbors read as negative until their own reset
+    for (int k = 0; k < 4; k++) {
+        bool inside = (k == 0) ? x > 0 : (k == 1) ? x < W - 1 : (k == 2) ? y > 0 : y < H - 1;
+        if (!inside)
+            continue;
+
+        int j = layout_neighbor(CELL_LAYOUT, W, idx, k);
+        if (dist[j] >= 0)
+            wave_append(wf_idxs, wf_size, WF_CAP, j);
+    }
+}
+
+// Forgets every distance at or past bound, launched over every cell. Used
+// when a repair moved the target further away, the cells past its old
+// distance were never expanded.
+__kernel void clear_distances_from(
+    int W, int H,
+    __global int *dist,
+    int bound
+) {
+    FIX_DIMS(W, H);
+    int idx = get_global_id(0);
+    if (idx >= layout_cells(CELL_LAYOUT, W, H))
+        return;
+
+    if (dist[idx] >= bound)
+        dist[idx] = -1;
+}
+
+#endif
@@ -7,24 +7,21 @@ M_EMPT = 0
 M_WALL = 1
 
 
-def init_maze(size):
-    L = size
-    lattice = [[M_WALL for _ in range(L)] for _ in range(L)]
-    visited = [[False  for _ in range(L)] for _ in range(L)]
+def init_maze(width, height):
+    lattice = [[M_WALL for _ in range(width)] for _ in range(height)]
+    visited = [[False  for _ in range(width)] for _ in range(height)]
     
-    idxs = range(1, L, 2)
-    for i in idxs:
-        for j in idxs:
+    for i in range(1, height, 2):
+        for j in range(1, width, 2):
             lattice[i][j] = M_EMPT 
     return lattice, visited
 
 
-def make_maze_depthfs(size, start_idx=None):
+def make_maze_depthfs(width, height, start_idx=None):
     if not start_idx: start_idx = (1,1)
     sx, sy = start_idx
-    lattice, visited = init_maze(size)
+    lattice, visited = init_maze(width, height)
     assert lattice[sx][sy] == M_EMPT
-    L = size
     
     offs = [(-1, 0), (+1,0), (0, -1), (0, +1)]
     stack = [start_idx]
@@ -38,7 +35,7 @@ def make_maze_depthfs(size, start_idx=None):
         removed = False
         for dx, dy in directions:
             nx, ny = cx + 2*dx, cy + 2*dy
-            if not (0 <= nx < L and 0 <= ny < L):
+            if not (0 <= nx < height and 0 <= ny < width):
                 continue
             if not visited[nx][ny]:
                 # remove wall
@@ -54,17 +51,17 @@ def make_maze_depthfs(size, start_idx=None):
     return lattice
 
 
-def make_maze_kruskal(size, start_idx=None):
+def make_maze_kruskal(width, height, start_idx=None):
     sx, sy = start_idx
-    lattice, _ = init_maze(size)
+    lattice, _ = init_maze(width, height)
     assert lattice[sx][sy] == M_EMPT
-    L = size
-    Eidxs = range(1, L, 2)
+    rows = range(1, height, 2)
+    cols = range(1, width, 2)
 
     # Initialize disjoint sets (each empty cell is its own set)
     parent = {}
-    for i in Eidxs:
-        for j in Eidxs:
+    for i in rows:
+        for j in cols:
             lattice[i][j] = M_EMPT
             parent[(i, j)] = (i, j)
 
@@ -83,11 +80,11 @@ def make_maze_kruskal(size, start_idx=None):
 
     # Build list of walls that could connect two cells
     walls = []
-    for i in Eidxs:
-        for j in Eidxs:
-            if i < L - 2:  # wall between (i,j) and (i+2,j)
+    for i in rows:
+        for j in cols:
+            if i < height - 2:  # wall between (i,j) and (i+2,j)
                 walls.append(((i + 1, j), (i, j), (i + 2, j)))
-            if j < L - 2:  # wall between (i,j) and (i,j+2)
+            if j < width - 2:  # wall between (i,j) and (i,j+2)
                 walls.append(((i, j + 1), (i, j), (i, j + 2)))
 
     random.shuffle(walls)
@@ -101,23 +98,37 @@ def make_maze_kruskal(size, start_idx=None):
     return lattice
 
 
+def make_maze_open(width, height, start_idx=None, density=0.2):
+    # Open grid with scattered walls, vectorized and drawn as bytes so very
+    # large grids stay fast and small
+    noise = np.random.default_rng().integers(0, 256, size=(height, width), dtype=np.uint8)
+    lattice = (noise < int(density * 256)).astype(np.uint8) * M_WALL
+    lattice[0, :] = lattice[-1, :] = M_WALL
+    lattice[:, 0] = lattice[:, -1] = M_WALL
+    lattice[1, 1] = lattice[height - 2, width - 2] = M_EMPT
+    return lattice
+
+
 if __name__ == "__main__":
-    if len(sys.argv) != 3:
+    # gen_maze.py <size> <algo> or gen_maze.py <width> <height> <algo>
+    if len(sys.argv) not in (3, 4):
         exit(1)
     else:
         ALGOS = {
             "depthfs": make_maze_depthfs,
             "kruskal": make_maze_kruskal,
+            "open": make_maze_open,
         }
         
         
-        SIZE = int(sys.argv[1])
-        ALGO = str(sys.argv[2])
+        WIDTH = int(sys.argv[1])
+        HEIGHT = int(sys.argv[2]) if len(sys.argv) == 4 else WIDTH
+        ALGO = str(sys.argv[-1])
         assert ALGO in ALGOS, f"No algorithm named {ALGO}"
         
         func = ALGOS[ALGO]
         
-        maze = np.array(func(SIZE, (1,1)), dtype=np.uint8)
+        maze = np.array(func(WIDTH, HEIGHT, (1,1)), dtype=np.uint8)
         
         print(maze)
         
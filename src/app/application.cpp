@@ -5,6 +5,8 @@
 #include "../graphics/quad.h"
 #include "../compute/cl_context.h"
 #include "../compute/cl_program.h"
+#include "../compute/cl_program_cache.h"
+#include "../compute/cl_device_group.h"
 #include "../maze/pathfinding.h"
 #include "../utils/file_utils.h"
 
@@ -20,6 +22,8 @@
 #include "backends/imgui_impl_opengl3.h"
 
 #include <iostream>
+#include <fstream>
+#include <filesystem>
 #include <algorithm>
 
 namespace App {
@@ -29,12 +33,46 @@ Application::Application(int width, int height)
     , m_height(height)
     , m_window(nullptr)
     , m_glContext(nullptr)
+    , m_clProgramUniform(nullptr)
+    , m_clProgramWeights(nullptr)
     , m_isRunning(true)
     , m_isBacktracking(false)
     , m_pathFound(false)
+    , m_pathCursor(0)
     , m_currentStep(0)
+    , m_stepsPerFrame(1)
+    , m_syncInterval(16)
+    , m_solveNow(false)
     , m_useWeightedKernel(false)
-    , m_mazeSize(65)
+    , m_useDirectionOptimizing(false)
+    , m_useDeltaStepping(false)
+    , m_useBidirectional(false)
+    , m_useAStar(false)
+    , m_useTiled(false)
+    , m_useCpuBackend(false)
+    , m_cpuBackendActive(false)
+    , m_useBitParallel(false)
+    , m_bitParallelActive(false)
+    , m_useJps(false)
+    , m_jpsActive(false)
+    , m_useHpa(false)
+    , m_hpaActive(false)
+    , m_useAlt(false)
+    , m_altActive(false)
+    , m_useStreaming(false)
+    , m_streamingActive(false)
+    , m_useStrips(false)
+    , m_stripsActive(false)
+    , m_stripSubDevices(0)
+    , m_deviceGroupSplit(0)
+    , m_useBlockedLayout(false)
+    , m_cellLayout(LAYOUT_ROW_MAJOR)
+    , m_useSpecializedKernels(true)
+    , m_editX(2)
+    , m_editY(1)
+    , m_editCost(-1)
+    , m_mazeWidth(65)
+    , m_mazeHeight(65)
     , m_currentWavefrontSize(1)
 {
     initSDL();
@@ -92,74 +130,238 @@ void Application::initOpenGL()
 void Application::initOpenCL()
 {
     m_clContext = std::make_unique<Compute::CLContext>(m_window, 0, 0);
+    m_programCache = std::make_unique<Compute::CLProgramCache>(m_clContext->getContext(), m_clContext->getDevice());
+}
 
-    m_clProgramUniform = std::make_unique<Compute::CLProgram>(
-        "assets/kernels/step_wavefront_uniform.cl",
-        m_clContext->getContext(),
-        m_clContext->getDevice()
-    );
-
-    m_clProgramWeights = std::make_unique<Compute::CLProgram>(
-        "assets/kernels/step_wavefront_weights.cl",
-        m_clContext->getContext(),
-        m_clContext->getDevice()
-    );
+void Application::buildPrograms()
+{
+    // The cell layout is compiled into the kernels, specialized variants also
+    // fix the maze size. Variants that were built before come from the cache.
+    const std::string options = m_useSpecializedKernels
+        ? Maze::kernelOptions(m_cellLayout, m_mazeWidth, m_mazeHeight)
+        : Maze::kernelOptions(m_cellLayout);
+
+    m_clProgramUniform = &m_programCache->get("assets/kernels/step_wavefront_uniform.cl", options);
+    m_clProgramWeights = &m_programCache->get("assets/kernels/step_wavefront_weights.cl", options);
 }
 
 void Application::initMaze()
 {
     // Generate maze
-    m_hostMazeCosts = Maze::createMaze(m_mazeSize, m_algorithm, m_useWeightedKernel);
+    m_hostMazeCosts = Maze::createMaze(m_mazeWidth, m_mazeHeight, m_algorithm, m_useWeightedKernel);
+    buildPrograms();
 
     if (m_hostMazeCosts.empty())
     {
         throw std::runtime_error("Failed to generate maze");
     }
+    m_landmarks.cells.clear();
 
     // Calculate indices
-    auto toIndex = [this](int r, int c) { return r * m_mazeSize + c; };
+    auto toIndex = [this](int r, int c) { return r * m_mazeWidth + c; };
     m_startIdx = toIndex(1, 1);
-    m_targetIdx = toIndex(m_mazeSize - 2, m_mazeSize - 2);
-
-    // Create wall buffer for graphics
-    m_costBuffer = std::make_unique<Graphics::SSBO>(
-        m_hostMazeCosts.size() * sizeof(int32_t),
-        m_hostMazeCosts.data()
+    m_targetIdx = toIndex(m_mazeHeight - 2, m_mazeWidth - 2);
+
+    // Create cell buffer for graphics, one encoded byte per cell like the
+    // uniform kernels and in their layout, padded to whole words for the shader
+    const std::vector<uint16_t> cells = Maze::toDeviceLayout(
+        Maze::encodeCells(m_hostMazeCosts, m_mazeWidth, m_mazeHeight), m_mazeWidth, m_mazeHeight, m_cellLayout, uint16_t(0));
+    std::vector<uint8_t> cellBytes((cells.size() + 3) / 4 * 4, 0);
+    std::copy(cells.begin(), cells.end(), cellBytes.begin());
+    m_cellBuffer = std::make_unique<Graphics::SSBO>(
+        cellBytes.size() * sizeof(uint8_t),
+        cellBytes.data()
     );
 
-    // Initialize distance buffer
-    std::vector<int32_t> distances(m_mazeSize * m_mazeSize, -1);
+    // Initialize distance buffer, 16 bit distances packed two per word
+    std::vector<int32_t> distances(m_hostMazeCosts.size(), -1);
     distances[m_startIdx] = 0;
-    
+    std::vector<uint16_t> view;
+    Maze::narrowDistances(distances, m_mazeWidth, m_mazeHeight, m_cellLayout, view);
+
     m_distBuffer = std::make_unique<Graphics::SSBO>(
-        distances.size() * sizeof(int32_t),
-        distances.data()
+        view.size() * sizeof(uint16_t),
+        view.data()
     );
 
-    std::vector<int32_t> visited(m_mazeSize * m_mazeSize, 0);
+    std::vector<int32_t> visited(layout_cells(m_cellLayout, m_mazeWidth, m_mazeHeight), 0);
     m_visitBuffer = std::make_unique<Graphics::SSBO>(
         visited.size() * sizeof(int32_t),
         visited.data()
     );
 
     // Initialize OpenCL buffers for pathfinding
-    const int maxWfSize = 2 * (std::max(m_mazeSize, m_mazeSize) - 1);
-    const int indexArrSize = 4 * maxWfSize;
+    initMazeState();
+}
+
+void Application::initMazeState()
+{
+    m_cpuBackendActive = m_useCpuBackend;
+    m_streamingActive = !m_useCpuBackend && m_useStreaming && !m_useWeightedKernel;
+    m_stripsActive = !m_useCpuBackend && m_useStrips && !m_useWeightedKernel && !m_streamingActive;
+    m_hpaActive = m_useCpuBackend && m_useHpa;
+    m_altActive = m_useCpuBackend && m_useAlt && !m_hpaActive;
+    if (m_altActive && (m_landmarks.cells.empty() || m_landmarks.weighted != m_useWeightedKernel))
+    {
+        // Landmark fields only depend on the maze and the kernel, restarts reuse
+        // them. Without exact fields the query falls back to the solvers below.
+        m_altActive = Maze::buildLandmarks(
+            *m_clContext,
+            m_useWeightedKernel ? *m_clProgramWeights : *m_clProgramUniform,
+            m_hostMazeCosts,
+            m_mazeWidth,
+            m_mazeHeight,
+            m_useWeightedKernel,
+            m_cellLayout,
+            m_landmarks
+        );
+    }
+    m_jpsActive = m_useCpuBackend && m_useJps && !m_useWeightedKernel && !m_hpaActive && !m_altActive;
+    m_bitParallelActive = m_useCpuBackend && m_useBitParallel && !m_useWeightedKernel && !m_jpsActive;
+    if (m_cpuBackendActive)
+    {
+        // Only the host side buffers of m_mazeState are used for rendering
+        m_mazeState.bidirectional = false;
+        m_mazeState.layout = m_cellLayout;
+        m_mazeState.distHost.assign(m_hostMazeCosts.size(), -1);
+        m_mazeState.visitedFlag.assign(layout_cells(m_cellLayout, m_mazeWidth, m_mazeHeight), 0);
+
+        m_cpuState.weighted = m_useWeightedKernel;
+        bool initialized = true;
+        if (m_hpaActive)
+            initialized = Maze::buildHpaGraph(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_hpaGraph);
+        else if (m_jpsActive)
+            initialized = Maze::initializeJpsState(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_jpsState);
+        else if (m_bitParallelActive)
+            initialized = Maze::initializeBitBfsState(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_bitState);
+        else if (!m_altActive)
+            initialized = Maze::initializeCpuMazeState(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_cpuState);
+        if (!initialized)
+        {
+            throw std::runtime_error("Failed to initialize maze.");
+        }
+
+        m_currentStep = 0;
+        m_currentWavefrontSize = 1;
+        return;
+    }
+
+    // The search reads the maze back from a file like it would a maze too
+    // large for memory, one byte per cell with 1 for walls. A failed write
+    // falls back to the in-memory solvers.
+    const std::filesystem::path streamDir = "stream_files";
+    const std::string mazePath = (streamDir / "maze_stream.bin").string();
+    const std::string distPath = (streamDir / "dist_stream.bin").string();
+    if (m_streamingActive)
+    {
+        std::vector<uint8_t> mazeBytes(m_hostMazeCosts.size());
+        std::transform(m_hostMazeCosts.begin(), m_hostMazeCosts.end(), mazeBytes.begin(),
+            [](int32_t cost) { return static_cast<uint8_t>(cost < 0 ? 1 : 0); });
+        m_streamingState.mazeFile.close();
+
+        std::error_code error;
+        std::filesystem::create_directories(streamDir, error);
+        std::ofstream file(mazePath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(mazeBytes.data()), mazeBytes.size());
+        file.close();
+        if (!file.good())
+        {
+            std::cerr << "Failed to write streaming maze file " << mazePath << ", streaming disabled." << std::endl;
+            m_streamingActive = false;
+        }
+    }
+
+    if (m_streamingActive)
+    {
+        // Only the host side buffers of m_mazeState are used for rendering
+        m_mazeState.bidirectional = false;
+        m_mazeState.layout = m_cellLayout;
+        m_mazeState.distHost.assign(m_hostMazeCosts.size(), -1);
+        m_mazeState.visitedFlag.assign(layout_cells(m_cellLayout, m_mazeWidth, m_mazeHeight), 0);
+
+        // The windows are smaller than the maze, they need the variant that takes the size as arguments
+        m_streamingState.layout = m_cellLayout;
+        if (!Maze::initializeStreamingState(
+                *m_clContext,
+                m_programCache->get("assets/kernels/step_wavefront_uniform.cl", Maze::kernelOptions(m_cellLayout)),
+                mazePath,
+                distPath,
+                m_mazeWidth,
+                m_mazeHeight,
+                m_startIdx,
+                m_targetIdx,
+                m_streamingState
+            ))
+        {
+            throw std::runtime_error("Failed to initialize maze.");
+        }
+
+        m_currentStep = 0;
+        m_currentWavefrontSize = 1;
+        return;
+    }
+
+    if (m_stripsActive)
+    {
+        // The group has no GL interop, its distances reach the renderer through the host
+        if (!m_deviceGroup || m_deviceGroupSplit != m_stripSubDevices)
+        {
+            m_deviceGroup = std::make_unique<Compute::CLDeviceGroup>(m_clContext->getPlatform(), m_stripSubDevices);
+            m_deviceGroupSplit = m_stripSubDevices;
+            m_clProgramStrips = std::make_unique<Compute::CLProgram>(
+                "assets/kernels/step_wavefront_uniform.cl",
+                m_deviceGroup->getContext(),
+                m_deviceGroup->getDevices(),
+                Maze::kernelOptions(LAYOUT_ROW_MAJOR)
+            );
+        }
+
+        // Only the host side buffers of m_mazeState are used for rendering
+        m_mazeState.bidirectional = false;
+        m_mazeState.layout = m_cellLayout;
+        m_mazeState.distHost.assign(m_hostMazeCosts.size(), -1);
+        m_mazeState.visitedFlag.assign(layout_cells(m_cellLayout, m_mazeWidth, m_mazeHeight), 0);
+
+        if (!Maze::initializeStripState(
+                *m_deviceGroup,
+                *m_clProgramStrips,
+                m_hostMazeCosts,
+                m_mazeWidth,
+                m_mazeHeight,
+                m_startIdx,
+                m_stripState
+            ))
+        {
+            throw std::runtime_error("Failed to initialize maze.");
+        }
 
-    // Create host buffers
-    std::vector<int32_t> prevHost(indexArrSize, -1);
-    std::vector<int32_t> nextHost(indexArrSize, -1);
-    std::vector<uint8_t> foundFlagHost(1, 0);
+        m_currentStep = 0;
+        m_currentWavefrontSize = 1;
+        return;
+    }
 
     Compute::CLProgram& clProgram = m_useWeightedKernel 
         ? *m_clProgramWeights
         : *m_clProgramUniform;
+
+    // Engine options have to be set before the state is initialized
+    m_mazeState.aStar = m_useAStar;
+    m_mazeState.tiled = m_useTiled && !m_useAStar;
+    m_mazeState.bidirectional = m_useBidirectional && !m_useWeightedKernel && !m_useAStar && !m_mazeState.tiled;
+    m_mazeState.directionOptimizing = m_useDirectionOptimizing && !m_useWeightedKernel && !m_useAStar && !m_mazeState.tiled && !m_mazeState.bidirectional;
+    m_mazeState.deltaStepping = m_useDeltaStepping && m_useWeightedKernel && !m_useAStar && !m_mazeState.tiled;
+    m_mazeState.weighted = m_useWeightedKernel;
+    m_mazeState.layout = m_cellLayout;
+
+    // Reinitializing also resets the wavefronts and distances
     if (!Maze::initializeMazeState(
             *m_clContext,
             clProgram,
             m_hostMazeCosts,
-            m_mazeSize,
+            m_mazeWidth,
+            m_mazeHeight,
             m_startIdx,
+            m_targetIdx,
             m_mazeState
         ))
     {
@@ -167,14 +369,14 @@ void Application::initMaze()
     }
 
     m_currentStep = 0;
-    m_currentWavefrontSize = 1;
+    m_currentWavefrontSize = m_mazeState.bidirectional ? 2 : 1;
 }
 
 void Application::initGraphics()
 {
     // Load shaders
     std::string vertSrc = Utils::readFile("assets/shaders/shader.vert");
-    std::string fragSrc = Utils::readFile("assets/shaders/shader.frag");
+    std::string fragSrc = Utils::readSourceFile("assets/shaders/shader.frag");
 
     if (vertSrc.empty() || fragSrc.empty())
     {
@@ -186,8 +388,9 @@ void Application::initGraphics()
 
     // Setup shader uniforms
     m_shader->use();
-    m_shader->setInt("imageWidth", m_mazeSize);
-    m_shader->setInt("imageHeight", m_mazeSize);
+    m_shader->setInt("imageWidth", m_mazeWidth);
+    m_shader->setInt("imageHeight", m_mazeHeight);
+    m_shader->setInt("cellLayout", m_cellLayout);
 
     // Setup camera
     m_camera = std::make_unique<Camera2D>();
@@ -261,153 +464,300 @@ void Application::handleEvents()
 
 void Application::update()
 {
-    static int currBacktrackingIdx = -1;
-    static int currBacktrackingDst = -1;
-
-    // step backtracking
+    // Animate the extracted path from the target back to the start,
+    // only the flags of the newly revealed cells are uploaded
     if (m_isBacktracking) {
-        int neighbors[] = {
-            currBacktrackingIdx - 1,
-            currBacktrackingIdx + 1,
-            currBacktrackingIdx - m_mazeSize,
-            currBacktrackingIdx + m_mazeSize
-        };
-
-        int nextIdx = -1;
-
-        for (int i = 0; i < 4; ++i) {
-            int n = neighbors[i];
-            
-            // bounds check
-            if (n < 0 || n >= m_mazeSize * m_mazeSize)
-                continue;
-            
-            // skip walls and already backtracked
-            if (m_hostMazeCosts[n] < 0 ||
-                m_mazeState.visitedFlag[n])
-                continue;
-
-            if (m_mazeState.distHost[n] >= 0 &&
-                m_mazeState.distHost[n] <= currBacktrackingDst) {
-                currBacktrackingDst = m_mazeState.distHost[n];
-                nextIdx = n;
-            }
-        }
-
-        if (nextIdx == -1) {
-            // stuck, should not happen if path exists
-            m_isBacktracking = false;
-            std::cout << "Backtracking stuck!" << std::endl;
-        } else {
-            currBacktrackingIdx = nextIdx;
-            m_mazeState.visitedFlag[currBacktrackingIdx] = 2; // mark path 
-            m_visitBuffer->update(sizeof(int32_t) * m_mazeState.visitedFlag.size(), m_mazeState.visitedFlag.data());
-            // done if on start
-            m_isBacktracking = currBacktrackingIdx != m_startIdx;
-            std::cout << "Backtracking @" << currBacktrackingIdx << "\n";
+        const int reveal = std::min<int>(m_stepsPerFrame, static_cast<int>(m_pathCursor));
+        for (int i = 0; i < reveal; ++i) {
+            const int32_t idx = Maze::deviceIndex(m_cellLayout, m_mazeWidth, m_path[--m_pathCursor]);
+            m_mazeState.visitedFlag[idx] = 2; // mark path
+            m_visitBuffer->updateRange(sizeof(int32_t) * idx, sizeof(int32_t), &m_mazeState.visitedFlag[idx]);
         }
+        m_isBacktracking = m_pathCursor > 0;
     }
 
     if (m_pathFound)
         return;
 
-    // Run pathfinding step
-    m_pathFound = Maze::stepPathfinding(
-        m_currentStep,
-        m_mazeSize,
-        m_currentWavefrontSize,
-        m_clContext->getQueue(),
-        m_mazeState.kernel,
-        m_targetIdx,
-        m_mazeState.costBuf,
-        m_mazeState.prevBuf,
-        m_mazeState.nextBuf,
-        m_mazeState.distBuf,
-        m_mazeState.foundFlagBuf,
-        m_mazeState.prevHost,
-        m_mazeState.nextHost,
-        m_mazeState.distHost,
-        m_mazeState.foundFlagHost
-    );
+    if (m_jpsActive || m_hpaActive || m_altActive) {
+        // A single query is answered at once, there are no steps to animate
+        if (m_currentWavefrontSize > 0) {
+            m_path = m_hpaActive
+                ? Maze::findPathHpa(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_targetIdx, m_hpaGraph)
+                : m_altActive
+                ? Maze::findPathAlt(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_targetIdx, m_landmarks)
+                : Maze::findPathJps(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_targetIdx, m_jpsState);
+            m_pathFound = !m_path.empty();
+            m_currentWavefrontSize = 0;
+            m_solveNow = false;
+        }
+
+        if (m_jpsActive)
+            m_mazeState.distHost = m_jpsState.dist;
+    }
+    else if (m_streamingActive) {
+        // Whole pages instead of steps, a frame processes m_stepsPerFrame of them
+        if (Maze::activePageCount(m_streamingState) > 0) {
+            m_pathFound = Maze::runStreaming(
+                m_clContext->getQueue(),
+                m_streamingState,
+                m_solveNow ? 0 : m_stepsPerFrame
+            );
+            m_solveNow = false;
+        }
+        m_currentWavefrontSize = static_cast<int>(Maze::activePageCount(m_streamingState));
+
+        Maze::readStreamingDistances(m_streamingState, m_mazeState.distHost);
+        m_currentStep = *std::max_element(m_mazeState.distHost.begin(), m_mazeState.distHost.end());
+    }
+    else if (m_stripsActive) {
+        if (m_currentWavefrontSize > 0 && (m_solveNow || m_stepsPerFrame > 1)) {
+            m_pathFound = Maze::runStrips(
+                m_currentStep,
+                m_currentWavefrontSize,
+                *m_deviceGroup,
+                m_targetIdx,
+                m_stripState,
+                m_solveNow ? 0 : m_stepsPerFrame
+            );
+            m_solveNow = false;
+        }
+        else if (m_currentWavefrontSize > 0) {
+            m_pathFound = Maze::stepStrips(
+                m_currentStep,
+                m_currentWavefrontSize,
+                *m_deviceGroup,
+                m_targetIdx,
+                m_stripState
+            );
+            ++m_currentStep;
+        }
+
+        Maze::readStripDistances(*m_deviceGroup, m_stripState, m_mazeState.distHost);
+    }
+    else if (m_bitParallelActive) {
+        if (m_solveNow || m_stepsPerFrame > 1) {
+            m_pathFound = Maze::runBitBfs(
+                m_currentStep,
+                m_mazeWidth,
+                m_mazeHeight,
+                m_currentWavefrontSize,
+                m_targetIdx,
+                m_bitState,
+                m_solveNow ? 0 : m_stepsPerFrame
+            );
+            m_solveNow = false;
+        }
+        else {
+            m_pathFound = Maze::stepBitBfs(
+                m_currentStep,
+                m_mazeWidth,
+                m_mazeHeight,
+                m_currentWavefrontSize,
+                m_targetIdx,
+                m_bitState
+            );
+            ++m_currentStep;
+        }
+
+        m_mazeState.distHost = m_bitState.dist;
+    }
+    else if (m_cpuBackendActive) {
+        if (m_solveNow || m_stepsPerFrame > 1) {
+            m_pathFound = Maze::runPathfindingCpu(
+                m_currentStep,
+                m_mazeWidth,
+                m_mazeHeight,
+                m_currentWavefrontSize,
+                m_targetIdx,
+                m_cpuState,
+                m_solveNow ? 0 : m_stepsPerFrame
+            );
+            m_solveNow = false;
+        }
+        else {
+            m_pathFound = Maze::stepPathfindingCpu(
+                m_currentStep,
+                m_mazeWidth,
+                m_mazeHeight,
+                m_currentWavefrontSize,
+                m_targetIdx,
+                m_cpuState
+            );
+            ++m_currentStep;
+        }
+
+        Maze::copyDistances(m_cpuState, m_mazeState.distHost);
+    }
+    else {
+        updateGpu();
+    }
 
-    // Update distance buffer for rendering
-    m_clContext->getQueue().enqueueReadBuffer(
-        m_mazeState.distBuf,
-        CL_TRUE,
-        0,
-        sizeof(int32_t) * m_mazeState.distHost.size(),
-        m_mazeState.distHost.data()
-    );
-    
-    m_distBuffer->update(
-        sizeof(int32_t) * m_mazeState.distHost.size(),
-        m_mazeState.distHost.data());
-    
     if (m_pathFound) {
-        m_isBacktracking = true;
-        std::cout << "Backtracking starting...\n";
-        currBacktrackingIdx = m_targetIdx;
-        currBacktrackingDst = m_mazeState.distHost[m_targetIdx];
+        // Both halves of a bidirectional path are known once the fronts meet,
+        // JPS, HPA* and ALT return the path itself
+        if (m_mazeState.bidirectional)
+            m_path = Maze::stitchBidirectionalPath(m_clContext->getQueue(), m_mazeWidth, m_mazeHeight, m_mazeState);
+        else if (m_streamingActive) {
+            const std::vector<int64_t> path = Maze::extractStreamingPath(m_streamingState);
+            m_path.assign(path.begin(), path.end());
+        }
+        else if (!m_jpsActive && !m_hpaActive && !m_altActive)
+            m_path = Maze::extractPath(m_mazeState.distHost, m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_targetIdx, m_mazeState.weighted);
+        m_pathCursor = m_path.size();
+        m_isBacktracking = !m_path.empty();
+        std::cout << "Extracted path of " << m_path.size() << " cells" << std::endl;
+    }
+
+    if (m_mazeState.bidirectional) {
+        // Show the reverse wavefront where the forward one has not been
+        std::vector<int32_t> shown = m_mazeState.distHost;
+        for (size_t i = 0; i < shown.size(); ++i) {
+            if (shown[i] < 0)
+                shown[i] = m_mazeState.distRevHost[i];
+        }
+        Maze::narrowDistances(shown, m_mazeWidth, m_mazeHeight, m_cellLayout, m_mazeState.distView);
+    }
+    else if (m_cpuBackendActive || m_streamingActive || m_stripsActive || m_pathFound) {
+        // Running GPU searches fill the view on the device
+        Maze::narrowDistances(m_mazeState.distHost, m_mazeWidth, m_mazeHeight, m_cellLayout, m_mazeState.distView);
+    }
+    m_distBuffer->update(
+        sizeof(uint16_t) * m_mazeState.distView.size(),
+        m_mazeState.distView.data());
+}
+
+void Application::updateGpu()
+{
+    // Run pathfinding steps, several steps per frame only sync every m_syncInterval steps
+    if (m_solveNow || m_stepsPerFrame > 1)
+    {
+        m_pathFound = Maze::runPathfinding(
+            m_currentStep,
+            m_mazeWidth,
+            m_mazeHeight,
+            m_currentWavefrontSize,
+            m_clContext->getQueue(),
+            m_targetIdx,
+            m_mazeState,
+            m_solveNow ? 0 : m_stepsPerFrame,
+            m_syncInterval
+        );
+        m_solveNow = false;
+    }
+    else
+    {
+        m_pathFound = Maze::stepPathfinding(
+            m_currentStep,
+            m_mazeWidth,
+            m_mazeHeight,
+            m_currentWavefrontSize,
+            m_clContext->getQueue(),
+            m_targetIdx,
+            m_mazeState
+        );
+        ++m_currentStep;
+    }
+
+    if (m_mazeState.bidirectional && !m_pathFound) {
+        Maze::readDistances(m_clContext->getQueue(), m_mazeState.distRevBuf, m_mazeWidth, m_mazeHeight, m_cellLayout, m_mazeState.distRevHost);
+    }
+
+    // Rendering only needs 16 bit distances, the full field is read for the
+    // path and for merging the two bidirectional fields
+    if (!m_pathFound && !m_mazeState.bidirectional) {
+        Maze::readDistanceView(m_clContext->getQueue(), m_clContext->getTransferQueue(), m_mazeState);
+        return;
     }
+    Maze::readDistances(m_clContext->getQueue(), m_mazeState.distBuf, m_mazeWidth, m_mazeHeight, m_cellLayout, m_mazeState.distHost);
+}
+
+bool Application::applyCellEdit(const Maze::CellEdit& edit)
+{
+    // Only finished GPU runs hold a complete distance field to repair
+    const bool finished = m_pathFound || m_currentWavefrontSize == 0;
+    const bool repairable = finished && !m_cpuBackendActive && !m_streamingActive && !m_stripsActive
+        && Maze::canRepair(m_mazeState);
+    bool repaired = false;
+    if (repairable)
+    {
+        repaired = Maze::repairDistances(
+            m_clContext->getQueue(),
+            m_mazeWidth,
+            m_mazeHeight,
+            m_startIdx,
+            m_targetIdx,
+            { edit },
+            m_hostMazeCosts,
+            m_mazeState
+        );
+    }
+    else
+    {
+        m_hostMazeCosts[edit.idx] = edit.cost;
+    }
+    // Landmark fields were computed on the maze before the edit
+    m_landmarks.cells.clear();
+
+    // The renderer takes the low byte of the edited cell and its neighbors
+    const int x = edit.idx % m_mazeWidth;
+    const int y = edit.idx / m_mazeWidth;
+    const int dx[5] = { 0, -1, 1, 0, 0 };
+    const int dy[5] = { 0, 0, 0, -1, 1 };
+    for (int k = 0; k < 5; ++k)
+    {
+        const int nx = x + dx[k];
+        const int ny = y + dy[k];
+        if (nx < 0 || nx >= m_mazeWidth || ny < 0 || ny >= m_mazeHeight)
+            continue;
+
+        const uint8_t cell = static_cast<uint8_t>(Maze::encodeCell(m_hostMazeCosts, m_mazeWidth, m_mazeHeight, nx, ny));
+        const int idx = layout_index(m_cellLayout, m_mazeWidth, nx, ny);
+        m_cellBuffer->updateRange(sizeof(uint8_t) * idx, sizeof(uint8_t), &cell);
+    }
+
+    if (!repaired)
+        return false;
+
+    // Show the new path from scratch, the old one may run through the edit
+    Maze::readDistances(m_clContext->getQueue(), m_mazeState.distBuf, m_mazeWidth, m_mazeHeight, m_cellLayout, m_mazeState.distHost);
+    std::fill(m_mazeState.visitedFlag.begin(), m_mazeState.visitedFlag.end(), 0);
+    m_visitBuffer->update(sizeof(int32_t) * m_mazeState.visitedFlag.size(), m_mazeState.visitedFlag.data());
+
+    m_path = Maze::extractPath(m_mazeState.distHost, m_hostMazeCosts, m_mazeWidth, m_mazeHeight, m_startIdx, m_targetIdx, m_mazeState.weighted);
+    m_pathFound = !m_path.empty();
+    m_pathCursor = m_path.size();
+    m_isBacktracking = m_pathFound;
+    m_currentWavefrontSize = 0;
+
+    Maze::narrowDistances(m_mazeState.distHost, m_mazeWidth, m_mazeHeight, m_cellLayout, m_mazeState.distView);
+    m_distBuffer->update(sizeof(uint16_t) * m_mazeState.distView.size(), m_mazeState.distView.data());
+    return true;
 }
 
 void Application::renderImgui()
 {
     auto onRestart = [&]() {
-        Compute::CLProgram& clProgram = m_useWeightedKernel 
-            ? *m_clProgramWeights 
-            : *m_clProgramUniform;
-        // Reinitialize state
-        if (!Maze::initializeMazeState(
-                *m_clContext,
-                clProgram,
-                m_hostMazeCosts,
-                m_mazeSize,
-                m_startIdx,
-                m_mazeState
-            ))
-        {
-            throw std::runtime_error("Failed to initialize maze.");
-        }
-
-        // Reset wavefront / pathfinding trackers
-        const int maxWfSize = 2 * (std::max(m_mazeSize, m_mazeSize) - 1);
-        const int indexArrSize = 4 * maxWfSize;
-
-        m_mazeState.prevHost.assign(indexArrSize, -1);
-        m_mazeState.nextHost.assign(indexArrSize, -1);
-        m_mazeState.distHost.assign(m_mazeSize * m_mazeSize, -1);
-        m_mazeState.distHost[m_startIdx] = 0;
-        m_mazeState.prevHost[0] = m_startIdx;
-        m_mazeState.foundFlagHost.assign(1, 0);
-
-        // Update OpenCL buffers to match
-        m_clContext->getQueue().enqueueWriteBuffer(m_mazeState.distBuf, CL_TRUE, 0,
-            sizeof(int32_t) * m_mazeState.distHost.size(), m_mazeState.distHost.data());
-        m_clContext->getQueue().enqueueWriteBuffer(m_mazeState.prevBuf, CL_TRUE, 0,
-            sizeof(int32_t) * m_mazeState.prevHost.size(), m_mazeState.prevHost.data());
-        m_clContext->getQueue().enqueueWriteBuffer(m_mazeState.nextBuf, CL_TRUE, 0,
-            sizeof(int32_t) * m_mazeState.nextHost.size(), m_mazeState.nextHost.data());
-        m_clContext->getQueue().enqueueWriteBuffer(m_mazeState.foundFlagBuf, CL_TRUE, 0,
-            sizeof(uint8_t), m_mazeState.foundFlagHost.data());
+        // Reinitialize state, this also resets the step counters
+        initMazeState();
 
         // Reset app-level counters
-        m_currentStep = 0;
-        m_currentWavefrontSize = 1;
         m_pathFound = false;
         m_isBacktracking = false;
+        m_path.clear();
+        m_pathCursor = 0;
 
         // reset backtracking visualization
-        m_mazeState.visitedFlag.assign(m_mazeSize * m_mazeSize, 0);
         m_visitBuffer->update(sizeof(int32_t) * m_mazeState.visitedFlag.size(), m_mazeState.visitedFlag.data());
     };
 
     // Selected algorithm
-    const char* algorithms[] = { "depthfs", "kruskal", "test" };
+    const char* algorithms[] = { "depthfs", "kruskal", "open", "test" };
     int selectedAlgoIdx =
         (m_algorithm == "depthfs") ? 0 : 
         (m_algorithm == "kruskal") ? 1 :
-        2;
+        (m_algorithm == "open") ? 2 :
+        3;
 
     // Render ImGui
     // Start the Dear ImGui frame
@@ -426,10 +776,92 @@ void Application::renderImgui()
 
         ImGui::Text("Gen algorithm: %s", m_algorithm.c_str());
         ImGui::Checkbox("Use weighted kernel", &m_useWeightedKernel);
+        ImGui::Checkbox("CPU backend", &m_useCpuBackend);
+        if (m_useCpuBackend) {
+            ImGui::Checkbox("Hierarchical search (HPA*)", &m_useHpa);
+            if (m_useHpa) {
+                ImGui::InputInt("Cluster size", &m_hpaGraph.clusterSize, 1, 8);
+                m_hpaGraph.clusterSize = std::max(m_hpaGraph.clusterSize, 2);
+            }
+            else {
+                ImGui::Checkbox("Landmark A* (ALT)", &m_useAlt);
+            }
+            if (!m_useHpa && m_useAlt) {
+                // A new count needs new fields
+                if (ImGui::InputInt("Landmarks", &m_landmarks.count, 1, 4)) {
+                    m_landmarks.count = std::clamp(m_landmarks.count, 1, 32);
+                    m_landmarks.cells.clear();
+                }
+            }
+        }
+        if (m_useCpuBackend && !m_useHpa && !m_useAlt && !m_useWeightedKernel) {
+            ImGui::Checkbox("Jump point search", &m_useJps);
+            if (m_useJps) {
+                ImGui::Checkbox("Precomputed jump table (JPS+)", &m_jpsState.usePlus);
+            }
+            else {
+                ImGui::Checkbox("Bit-parallel BFS", &m_useBitParallel);
+            }
+        }
+        if (!m_useCpuBackend) {
+            ImGui::Checkbox("A* search", &m_useAStar);
+            if (!m_useAStar) {
+                ImGui::Checkbox("Tiled relaxation", &m_useTiled);
+            }
+            if (!m_useWeightedKernel) {
+                ImGui::Checkbox("Out-of-core (streaming)", &m_useStreaming);
+            }
+            if (!m_useWeightedKernel && !m_useStreaming) {
+                ImGui::Checkbox("Multi-device strips", &m_useStrips);
+            }
+            if (m_useStrips && !m_useStreaming && !m_useWeightedKernel) {
+                // Applies on the next restart, the device group is created again
+                ImGui::InputInt("Sub-devices per device", &m_stripSubDevices, 1, 2);
+                m_stripSubDevices = std::max(m_stripSubDevices, 0);
+            }
+            if (m_useStreaming && !m_useWeightedKernel) {
+                // Whole tiles, a page is the window without its one cell halo
+                const int tile = Maze::MazeState::tileSize;
+                ImGui::InputInt("Window size", &m_streamingState.windowSize, tile, 8 * tile);
+                m_streamingState.windowSize = std::max(m_streamingState.windowSize / tile * tile, 2 * tile);
+            }
+        }
+        if (m_useAStar && !m_useCpuBackend) {
+            // A* replaces the engines below
+            ImGui::InputInt("f band width", &m_mazeState.fBand, 1, 32);
+            m_mazeState.fBand = std::max(m_mazeState.fBand, 1);
+        }
+        else if (m_useTiled && !m_useCpuBackend) {
+            ImGui::Text("Tile size: %d", Maze::MazeState::tileSize);
+        }
+        else if (m_useWeightedKernel) {
+            ImGui::Checkbox("Delta-stepping", &m_useDeltaStepping);
+            if (m_useDeltaStepping) {
+                ImGui::InputInt("Bucket width", &m_mazeState.delta, 1, 32);
+                m_mazeState.delta = std::max(m_mazeState.delta, 1);
+            }
+        }
+        else {
+            ImGui::Checkbox("Bidirectional BFS", &m_useBidirectional);
+            ImGui::Checkbox("Direction-optimizing BFS", &m_useDirectionOptimizing);
+            if (m_useDirectionOptimizing && !m_useBidirectional) {
+                ImGui::InputInt("Bottom-up alpha", &m_mazeState.buAlpha, 1, 8);
+                ImGui::InputInt("Bottom-up beta", &m_mazeState.buBeta, 1, 8);
+                m_mazeState.buAlpha = std::max(m_mazeState.buAlpha, 1);
+                m_mazeState.buBeta = std::max(m_mazeState.buBeta, m_mazeState.buAlpha);
+            }
+        }
 
-        ImGui::InputInt("Maze Size", &m_mazeSize, 1, 25);
+        ImGui::InputInt("Maze Width", &m_mazeWidth, 1, 25);
+        ImGui::InputInt("Maze Height", &m_mazeHeight, 1, 25);
+        m_mazeWidth = std::max(m_mazeWidth, 5);
+        m_mazeHeight = std::max(m_mazeHeight, 5);
+        ImGui::Checkbox("Blocked cell layout", &m_useBlockedLayout);
+        ImGui::Checkbox("Specialize kernels to the maze size", &m_useSpecializedKernels);
 
         if (ImGui::Button("Restart Map")) {
+            // initMaze picks the program variants of the new layout and size
+            m_cellLayout = m_useBlockedLayout ? LAYOUT_BLOCKED : LAYOUT_ROW_MAJOR;
             initMaze();
             initGraphics();
             onRestart();
@@ -438,6 +870,35 @@ void Application::renderImgui()
         if (ImGui::Button("Restart Run")) {
             onRestart();
         }
+
+        ImGui::Separator();
+        ImGui::InputInt("Steps per frame", &m_stepsPerFrame, 1, 16);
+        ImGui::InputInt("Sync interval", &m_syncInterval, 1, 16);
+        m_stepsPerFrame = std::max(m_stepsPerFrame, 1);
+        m_syncInterval = std::max(m_syncInterval, 1);
+
+        if (ImGui::Button("Solve now")) {
+            m_solveNow = true;
+        }
+
+        ImGui::Separator();
+        ImGui::InputInt("Edit x", &m_editX, 1, 8);
+        ImGui::InputInt("Edit y", &m_editY, 1, 8);
+        ImGui::InputInt("Edit cost", &m_editCost, 1, 16);
+        m_editX = std::clamp(m_editX, 0, m_mazeWidth - 1);
+        m_editY = std::clamp(m_editY, 0, m_mazeHeight - 1);
+        m_editCost = std::clamp(m_editCost, -1, 255);
+
+        if (ImGui::Button("Apply edit")) {
+            // Finished GPU runs repair their distances, anything else starts over
+            const Maze::CellEdit edit = { m_editY * m_mazeWidth + m_editX, m_editCost };
+            if (edit.idx == m_startIdx && edit.cost < 0) {
+                std::cerr << "The start cell cannot become a wall" << std::endl;
+            }
+            else if (!applyCellEdit(edit)) {
+                onRestart();
+            }
+        }
     ImGui::End();
 
     ImGui::Render();
@@ -459,10 +920,10 @@ void Application::render()
     GLint vpLoc = glGetUniformLocation(m_shader->getID(), "vp");
     glUniformMatrix4fv(vpLoc, 1, GL_FALSE, &vp[0][0]);
 
-    m_shader->setInt("maxDist", ++m_currentStep);
+    m_shader->setInt("maxDist", std::max(m_currentStep, 1));
 
     // Bind buffers
-    m_costBuffer->bind(0);
+    m_cellBuffer->bind(0);
     m_distBuffer->bind(1);
     m_visitBuffer->bind(2);
 
@@ -4,6 +4,14 @@
 #include <memory>
 #include <vector>
 #include "../maze/maze.h"
+#include "../maze/cpu_solver.h"
+#include "../maze/bit_bfs.h"
+#include "../maze/jps.h"
+#include "../maze/hpa.h"
+#include "../maze/landmarks.h"
+#include "../maze/streaming.h"
+#include "../maze/strips.h"
+#include "../maze/repair.h"
 
 // Forward declarations
 namespace Graphics {
@@ -15,6 +23,8 @@ namespace Graphics {
 namespace Compute {
     class CLContext;
     class CLProgram;
+    class CLProgramCache;
+    class CLDeviceGroup;
 }
 
 namespace App {
@@ -47,12 +57,16 @@ private:
     void initSDL();
     void initOpenGL();
     void initOpenCL();
+    void buildPrograms();
     void initMaze();
+    void initMazeState();
     void initGraphics();
     void initImGui();
     
     void handleEvents();
     void update();
+    void updateGpu();
+    bool applyCellEdit(const Maze::CellEdit& edit);
     void render();
     void renderImgui();
     void cleanup();
@@ -65,12 +79,15 @@ private:
 
     // OpenCL
     std::unique_ptr<Compute::CLContext> m_clContext;
-    std::unique_ptr<Compute::CLProgram> m_clProgramUniform;
-    std::unique_ptr<Compute::CLProgram> m_clProgramWeights;
+    std::unique_ptr<Compute::CLProgramCache> m_programCache; // variants by layout and maze size
+    Compute::CLProgram* m_clProgramUniform;                  // variants of the current maze, owned by m_programCache
+    Compute::CLProgram* m_clProgramWeights;
+    std::unique_ptr<Compute::CLDeviceGroup> m_deviceGroup;  // all devices of the platform, created for the first strip run
+    std::unique_ptr<Compute::CLProgram> m_clProgramStrips;  // uniform program built for m_deviceGroup
 
     // Graphics
     std::unique_ptr<Graphics::Shader> m_shader;
-    std::unique_ptr<Graphics::SSBO> m_costBuffer;
+    std::unique_ptr<Graphics::SSBO> m_cellBuffer;
     std::unique_ptr<Graphics::SSBO> m_distBuffer;
     std::unique_ptr<Graphics::SSBO> m_visitBuffer; // ssbo for backtracking visited state
     std::unique_ptr<Graphics::Quad> m_quad;
@@ -80,17 +97,57 @@ private:
     bool m_isRunning;
     bool m_isBacktracking;
     bool m_pathFound;
+    std::vector<int32_t> m_path; // start to target, extracted once the target is found
+    size_t m_pathCursor;         // cells of m_path not yet shown, revealed from the back
     int m_currentStep;
+    int m_stepsPerFrame;   // wavefront steps queued per frame
+    int m_syncInterval;    // steps between found flag checks when batching
+    bool m_solveNow;       // run the search to completion in the next update
     
     // Maze gen settings
     std::string m_algorithm = "kruskal"; // maze gen algo
     bool m_useWeightedKernel;
+    bool m_useDirectionOptimizing; // top-down / bottom-up BFS, uniform kernel only
+    bool m_useDeltaStepping;       // bucketed near-far relaxation, weighted kernel only
+    bool m_useBidirectional;       // second wavefront from the target, uniform kernel only
+    bool m_useAStar;               // wavefront ordered by distance plus heuristic, GPU backend only
+    bool m_useTiled;               // tiles relaxed in local memory, GPU backend only
+    bool m_useCpuBackend;          // native multithreaded solver instead of OpenCL
+    bool m_cpuBackendActive;       // backend of the current run, m_useCpuBackend applies on restart
+    bool m_useBitParallel;         // packed bit plane BFS on the CPU backend, uniform kernel only
+    bool m_bitParallelActive;
+    bool m_useJps;                 // jump point search on the CPU backend, uniform kernel only
+    bool m_jpsActive;
+    bool m_useHpa;                 // hierarchical search on cluster transitions on the CPU backend
+    bool m_hpaActive;
+    bool m_useAlt;                 // A* with landmark lower bounds on the CPU backend
+    bool m_altActive;
+    bool m_useStreaming;           // out-of-core paged search through mapped files, uniform GPU backend only
+    bool m_streamingActive;
+    bool m_useStrips;              // maze split into row strips over all devices, uniform GPU backend only
+    bool m_stripsActive;
+    int m_stripSubDevices;         // sub-devices per device for the strips, 0 keeps devices whole
+    int m_deviceGroupSplit;        // m_stripSubDevices m_deviceGroup was created with
+    bool m_useBlockedLayout;       // 8x8 blocked device grids, applies on map restart
+    int m_cellLayout;              // layout the programs and buffers were built with
+    bool m_useSpecializedKernels;  // programs with the maze size compiled in, applies on map restart
+    int m_editX;                   // cell changed by "Apply edit"
+    int m_editY;
+    int m_editCost;                // new cost of that cell, -1 for a wall
 
     // Maze data
-    int m_mazeSize;
+    int m_mazeWidth;
+    int m_mazeHeight;
     int m_startIdx;
     int m_targetIdx;
     Maze::MazeState m_mazeState;
+    Maze::CpuMazeState m_cpuState;
+    Maze::BitBfsState m_bitState;
+    Maze::JpsState m_jpsState;
+    Maze::HpaGraph m_hpaGraph;
+    Maze::LandmarkSet m_landmarks; // fields of the current maze, empty until ALT is first used
+    Maze::StreamingState m_streamingState;
+    Maze::StripState m_stripState;
     
     // Pathfinding state
     int m_currentWavefrontSize;
@@ -1,14 +1,21 @@
 #include "cl_context.h"
-#include "../platform/platform.h"
-#include <CL/cl_gl.h>
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
 
 namespace Compute {
 
-CLContext::CLContext(SDL_Window* window, unsigned int platformIndex, unsigned int deviceIndex)
+static std::string lowercase(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+CLContext::CLContext(cl_device_type deviceType, const std::string& namePreference)
 {
-    // Get all platforms
     std::vector<cl::Platform> platforms;
     cl::Platform::get(&platforms);
 
@@ -17,86 +24,48 @@ CLContext::CLContext(SDL_Window* window, unsigned int platformIndex, unsigned in
         throw std::runtime_error("No OpenCL platforms found");
     }
 
-    std::cout << "Number of OpenCL platforms: " << platforms.size() << std::endl;
-
-    // Print platform names
-    for (size_t i = 0; i < platforms.size(); ++i)
-    {
-        std::string name = platforms[i].getInfo<CL_PLATFORM_NAME>();
-        std::cout << "Platform " << i << ": " << name << std::endl;
-    }
-
-    // Select platform
-    if (platformIndex >= platforms.size())
+    // First device of the type, replaced by the first one matching the name
+    const std::string wanted = lowercase(namePreference);
+    bool found = false;
+    bool named = false;
+    for (cl::Platform& platform : platforms)
     {
-        platformIndex = 0;
-        std::cout << "Invalid platform index, using platform 0" << std::endl;
+        std::vector<cl::Device> devices;
+        if (platform.getDevices(deviceType, &devices) != CL_SUCCESS)
+            continue;
+
+        for (cl::Device& device : devices)
+        {
+            const std::string name = device.getInfo<CL_DEVICE_NAME>();
+            std::cout << "Found OpenCL device: " << name << " (" << platform.getInfo<CL_PLATFORM_NAME>() << ")" << std::endl;
+
+            const bool matches = !wanted.empty() && lowercase(name).find(wanted) != std::string::npos;
+            if (!found || (matches && !named))
+            {
+                m_platform = platform;
+                m_device = device;
+                found = true;
+                named = matches;
+            }
+        }
     }
-    m_platform = platforms[platformIndex];
-
-    // Setup GL interop context properties
-    cl_context_properties props[7] = {0};
-    
-#ifdef PLATFORM_WINDOWS
-    // WGL interop
-    props[0] = CL_CONTEXT_PLATFORM;
-    props[1] = (cl_context_properties)m_platform();
-    props[2] = CL_GL_CONTEXT_KHR;
-    props[3] = (cl_context_properties)wglGetCurrentContext();
-    props[4] = CL_WGL_HDC_KHR;
-    props[5] = (cl_context_properties)wglGetCurrentDC();
-    props[6] = 0;
-#elif defined(PLATFORM_LINUX)
-    // EGL interop
-    SDL_SysWMinfo wmInfo;
-    SDL_VERSION(&wmInfo.version);
-    if (!SDL_GetWindowWMInfo(window, &wmInfo))
-    {
-        throw std::runtime_error("Failed to get SDL window WM info");
-    }
-
-    EGLDisplay eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    eglInitialize(eglDisplay, nullptr, nullptr);
-    EGLContext eglContext = eglGetCurrentContext();
-
-    props[0] = CL_CONTEXT_PLATFORM;
-    props[1] = (cl_context_properties)m_platform();
-    props[2] = CL_GL_CONTEXT_KHR;
-    props[3] = (cl_context_properties)eglContext;
-    props[4] = CL_EGL_DISPLAY_KHR;
-    props[5] = (cl_context_properties)eglDisplay;
-    props[6] = 0;
-#else
-    throw std::runtime_error("Unsupported platform for GL-CL interop");
-#endif
-
-    // Get devices
-    std::vector<cl::Device> devices;
-    m_platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
 
-    if (devices.empty())
+    if (!found)
     {
-        throw std::runtime_error("No OpenCL devices found");
+        throw std::runtime_error("No OpenCL device of the requested type found");
     }
-
-    // Select device
-    if (deviceIndex >= devices.size())
+    if (!wanted.empty() && !named)
     {
-        deviceIndex = 0;
-        std::cout << "Invalid device index, using device 0" << std::endl;
+        std::cout << "No OpenCL device name contains \"" << namePreference << "\", using the first one" << std::endl;
     }
-    m_device = devices[deviceIndex];
-
-    std::string deviceName = m_device.getInfo<CL_DEVICE_NAME>();
-    std::cout << "Using OpenCL device: " << deviceName << std::endl;
+    std::cout << "Using OpenCL device: " << m_device.getInfo<CL_DEVICE_NAME>() << std::endl;
 
-    // Create context with properties
+    cl_context_properties props[] = {
+        CL_CONTEXT_PLATFORM, (cl_context_properties)m_platform(), 0
+    };
     m_context = cl::Context(m_device, props);
 
-    // Create command queue
-    m_queue = cl::CommandQueue(m_context, m_device);
-
-    std::cout << "OpenCL context created successfully" << std::endl;
+    createQueues();
 }
 
 CLContext::~CLContext()
@@ -106,6 +75,19 @@ CLContext::~CLContext()
     {
         m_queue.finish();
     }
+    if (m_transferQueue())
+    {
+        m_transferQueue.finish();
+    }
+}
+
+void CLContext::createQueues()
+{
+    // Kernels go to the first queue, display readbacks to the second
+    m_queue = cl::CommandQueue(m_context, m_device);
+    m_transferQueue = cl::CommandQueue(m_context, m_device);
+
+    std::cout << "OpenCL context created successfully" << std::endl;
 }
 
 } // namespace Compute
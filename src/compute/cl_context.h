@@ -2,13 +2,16 @@
 
 #define CL_HPP_TARGET_OPENCL_VERSION 300
 #include <CL/opencl.hpp>
-#include <SDL2/SDL.h>
 #include <string>
 
+// Only the GL interop constructor needs SDL, it lives in cl_context_gl.cpp
+// and is built with the application, not with the solver library
+struct SDL_Window;
+
 namespace Compute {
 
 /**
- * @brief OpenCL context wrapper with OpenGL interop support
+ * @brief OpenCL context wrapper, with OpenGL interop or headless
  */
 class CLContext
 {
@@ -20,6 +23,17 @@ public:
      * @param deviceIndex OpenCL device index (default: 0)
      */
     CLContext(SDL_Window* window, unsigned int platformIndex = 0, unsigned int deviceIndex = 0);
+
+    /**
+     * @brief Create a compute-only OpenCL context, no window or GL context is needed
+     *
+     * Looks through the devices of all platforms. A device whose name contains
+     * namePreference is taken over the first device of the type.
+     *
+     * @param deviceType Device types to consider, e.g. CL_DEVICE_TYPE_CPU or CL_DEVICE_TYPE_ALL
+     * @param namePreference Part of the device name to prefer, case-insensitive, empty takes the first device
+     */
+    explicit CLContext(cl_device_type deviceType, const std::string& namePreference = "");
     ~CLContext();
 
     // Disable copy, allow move
@@ -31,18 +45,30 @@ public:
     cl::Context& getContext() { return m_context; }
     cl::Device& getDevice() { return m_device; }
     cl::CommandQueue& getQueue() { return m_queue; }
+    cl::CommandQueue& getTransferQueue() { return m_transferQueue; }
     cl::Platform& getPlatform() { return m_platform; }
 
     const cl::Context& getContext() const { return m_context; }
     const cl::Device& getDevice() const { return m_device; }
     const cl::CommandQueue& getQueue() const { return m_queue; }
+    const cl::CommandQueue& getTransferQueue() const { return m_transferQueue; }
     const cl::Platform& getPlatform() const { return m_platform; }
 
+    /// Whether buffers can be shared with the GL context of the window
+    bool hasGLInterop() const { return m_glInterop; }
+
 private:
+    /**
+     * @brief Create the command queues on m_device once m_context exists
+     */
+    void createQueues();
+
+    bool m_glInterop = false;
     cl::Platform m_platform;
     cl::Device m_device;
     cl::Context m_context;
     cl::CommandQueue m_queue;
+    cl::CommandQueue m_transferQueue; /// readbacks that overlap the kernels of m_queue, ordered with events
 };
 
 } // namespace Compute
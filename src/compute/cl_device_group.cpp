@@ -0,0 +1,68 @@
+#include "cl_device_group.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Compute {
+
+CLDeviceGroup::CLDeviceGroup(const cl::Platform& platform, unsigned int subDevices)
+{
+    std::vector<cl::Device> devices;
+    platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+
+    if (devices.empty())
+    {
+        throw std::runtime_error("No OpenCL devices found");
+    }
+
+    for (cl::Device& device : devices)
+    {
+        // Sub-devices share the compute units of their parent equally
+        std::vector<cl::Device> parts;
+        const std::vector<cl_device_partition_property> partitions = device.getInfo<CL_DEVICE_PARTITION_PROPERTIES>();
+        const bool splittable = std::find(partitions.begin(), partitions.end(),
+            static_cast<cl_device_partition_property>(CL_DEVICE_PARTITION_EQUALLY)) != partitions.end();
+        if (subDevices > 1 && splittable)
+        {
+            const cl_uint units = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+            const cl_device_partition_property props[] = {
+                CL_DEVICE_PARTITION_EQUALLY,
+                static_cast<cl_device_partition_property>(std::max<cl_uint>(units / subDevices, 1)),
+                0
+            };
+            if (device.createSubDevices(props, &parts) != CL_SUCCESS)
+            {
+                std::cout << "Failed to split " << device.getInfo<CL_DEVICE_NAME>() << " into sub-devices" << std::endl;
+                parts.clear();
+            }
+        }
+
+        if (parts.empty())
+            parts.push_back(device);
+        m_devices.insert(m_devices.end(), parts.begin(), parts.end());
+    }
+
+    cl_context_properties props[] = {
+        CL_CONTEXT_PLATFORM, (cl_context_properties)platform(), 0
+    };
+    m_context = cl::Context(m_devices, props);
+
+    for (const cl::Device& device : m_devices)
+    {
+        m_queues.emplace_back(m_context, device);
+        std::cout << "Device group member " << m_queues.size() - 1 << ": " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+    }
+}
+
+CLDeviceGroup::~CLDeviceGroup()
+{
+    // Finish any pending operations
+    for (cl::CommandQueue& queue : m_queues)
+    {
+        if (queue())
+        {
+            queue.finish();
+        }
+    }
+}
+
+} // namespace Compute
@@ -0,0 +1,52 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+#include <vector>
+
+namespace Compute {
+
+/**
+ * @brief All devices of one platform in a shared context, one queue per device
+ *
+ * Unlike CLContext there is no GL interop, the devices only compute. Buffers
+ * of the context can be used on every device, each device works through its
+ * own queue so they run side by side.
+ */
+class CLDeviceGroup
+{
+public:
+    /**
+     * @brief Collect the devices of a platform, optionally split into sub-devices
+     * @param platform OpenCL platform, e.g. the one of the CLContext
+     * @param subDevices Split every device that supports CL_DEVICE_PARTITION_EQUALLY
+     *        into this many sub-devices, 0 or 1 keeps the devices whole
+     */
+    explicit CLDeviceGroup(const cl::Platform& platform, unsigned int subDevices = 0);
+    ~CLDeviceGroup();
+
+    // Disable copy, allow move
+    CLDeviceGroup(const CLDeviceGroup&) = delete;
+    CLDeviceGroup& operator=(const CLDeviceGroup&) = delete;
+    CLDeviceGroup(CLDeviceGroup&&) = default;
+    CLDeviceGroup& operator=(CLDeviceGroup&&) = default;
+
+    size_t deviceCount() const { return m_devices.size(); }
+
+    cl::Context& getContext() { return m_context; }
+    std::vector<cl::Device>& getDevices() { return m_devices; }
+    cl::Device& getDevice(size_t i) { return m_devices[i]; }
+    cl::CommandQueue& getQueue(size_t i) { return m_queues[i]; }
+
+    const cl::Context& getContext() const { return m_context; }
+    const std::vector<cl::Device>& getDevices() const { return m_devices; }
+    const cl::Device& getDevice(size_t i) const { return m_devices[i]; }
+    const cl::CommandQueue& getQueue(size_t i) const { return m_queues[i]; }
+
+private:
+    std::vector<cl::Device> m_devices;
+    cl::Context m_context;
+    std::vector<cl::CommandQueue> m_queues;
+};
+
+} // namespace Compute
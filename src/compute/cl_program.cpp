@@ -1,18 +1,79 @@
 #include "cl_program.h"
 #include "../utils/file_utils.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 namespace Compute {
 
-CLProgram::CLProgram(const std::string& filePath, cl::Context& context, cl::Device& device)
+/**
+ * @brief 64 bit FNV-1a hash, continued from a previous hash
+ */
+static uint64_t hashBytes(const std::string& bytes, uint64_t hash = 14695981039346656037ull)
 {
-    // Read source file
-    std::string sourceCode = Utils::readFile(filePath);
+    for (unsigned char c : bytes)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // Separates consecutive fields, "ab" + "c" and "a" + "bc" hash differently
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+/**
+ * @brief Path of the cache file of a program, empty if caching is off
+ */
+static std::string cacheFilePath(
+    const std::string& cacheDir,
+    const std::vector<cl::Device>& devices,
+    const std::string& sourceCode,
+    const std::string& buildOptions)
+{
+    if (cacheDir.empty())
+        return "";
+
+    uint64_t hash = hashBytes(sourceCode);
+    hash = hashBytes(buildOptions, hash);
+    for (const cl::Device& device : devices)
+    {
+        hash = hashBytes(device.getInfo<CL_DEVICE_NAME>(), hash);
+        hash = hashBytes(device.getInfo<CL_DRIVER_VERSION>(), hash);
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(cacheDir) / name).string();
+}
+
+CLProgram::CLProgram(const std::string& filePath, cl::Context& context, cl::Device& device,
+                     const std::string& buildOptions, const std::string& cacheDir)
+    : CLProgram(filePath, context, std::vector<cl::Device>{ device }, buildOptions, cacheDir)
+{
+}
+
+CLProgram::CLProgram(const std::string& filePath, cl::Context& context, const std::vector<cl::Device>& devices,
+                     const std::string& buildOptions, const std::string& cacheDir)
+{
+    // Read source file, shared headers are spliced in
+    std::string sourceCode = Utils::readSourceFile(filePath);
     if (sourceCode.empty())
     {
         throw std::runtime_error("Error: Kernel source file is empty or could not be read: " + filePath);
     }
 
+    // The key covers the expanded source, so edits of included headers count as well
+    const std::string cachePath = cacheFilePath(cacheDir, devices, sourceCode, buildOptions);
+    if (!cachePath.empty() && loadBinaries(cachePath, context, devices, buildOptions))
+    {
+        std::cout << "OpenCL program loaded from cache: " << filePath
+                  << (buildOptions.empty() ? "" : " with " + buildOptions) << std::endl;
+        return;
+    }
+
     // Create program from source
     cl::Program::Sources sources;
     sources.push_back({sourceCode.c_str(), sourceCode.length()});
@@ -20,13 +81,105 @@ CLProgram::CLProgram(const std::string& filePath, cl::Context& context, cl::Devi
     m_program = cl::Program(context, sources);
 
     // Try to build
-    cl_int buildErr = m_program.build({device});
+    cl_int buildErr = m_program.build(devices, buildOptions.c_str());
     if (buildErr != CL_SUCCESS)
     {
-        std::string buildLog = m_program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
+        std::string buildLog;
+        for (const cl::Device& device : devices)
+            buildLog += m_program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
         throw std::runtime_error("Failed to build OpenCL program (Error: " + std::to_string(buildErr) + "):\n" + buildLog);
     }
-    std::cout << "OpenCL program built successfully from: " << filePath << std::endl;
+    std::cout << "OpenCL program built successfully from: " << filePath
+              << (buildOptions.empty() ? "" : " with " + buildOptions) << std::endl;
+
+    if (!cachePath.empty())
+        saveBinaries(cachePath, devices.size());
+}
+
+bool CLProgram::loadBinaries(const std::string& cachePath, cl::Context& context, const std::vector<cl::Device>& devices,
+                             const std::string& buildOptions)
+{
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // One size and binary per device, in the order of the devices
+    uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || count != devices.size())
+        return false;
+
+    cl::Program::Binaries binaries(devices.size());
+    for (std::vector<unsigned char>& binary : binaries)
+    {
+        uint64_t size = 0;
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!file || size == 0 || size > (uint64_t(1) << 30))
+            return false;
+        binary.resize(static_cast<size_t>(size));
+        file.read(reinterpret_cast<char*>(binary.data()), static_cast<std::streamsize>(size));
+        if (!file)
+            return false;
+    }
+
+    // A driver update can reject binaries of the same version string, fall back to the source then
+    std::vector<cl_int> status;
+    cl_int err = CL_SUCCESS;
+    cl::Program program(context, devices, binaries, &status, &err);
+    if (err != CL_SUCCESS || program.build(devices, buildOptions.c_str()) != CL_SUCCESS)
+    {
+        std::cout << "Ignoring unusable cached program binary " << cachePath << std::endl;
+        return false;
+    }
+
+    m_program = program;
+    m_fromCache = true;
+    return true;
+}
+
+void CLProgram::saveBinaries(const std::string& cachePath, size_t deviceCount) const
+{
+    // Programs hold a binary per device of the context, only cache those built for all of them
+    const cl::Program::Binaries binaries = m_program.getInfo<CL_PROGRAM_BINARIES>();
+    if (binaries.size() != deviceCount)
+        return;
+    for (const std::vector<unsigned char>& binary : binaries)
+    {
+        if (binary.empty())
+            return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+
+    // Written under a temporary name so a concurrent start never reads half a file
+    const std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Failed to write program cache file: " << tempPath << std::endl;
+            return;
+        }
+
+        const uint64_t count = binaries.size();
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const std::vector<unsigned char>& binary : binaries)
+        {
+            const uint64_t size = binary.size();
+            file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            file.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(size));
+        }
+        if (!file)
+        {
+            std::cerr << "Failed to write program cache file: " << tempPath << std::endl;
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error)
+        std::cerr << "Failed to store program cache file " << cachePath << ": " << error.message() << std::endl;
 }
 
 } // namespace Compute
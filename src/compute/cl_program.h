@@ -3,22 +3,44 @@
 #define CL_HPP_TARGET_OPENCL_VERSION 300
 #include <CL/opencl.hpp>
 #include <string>
+#include <vector>
 
 namespace Compute {
 
 /**
  * @brief OpenCL program wrapper
+ *
+ * Built programs are kept as device binaries in a cache directory. A file is
+ * named after a hash of the device names, driver versions, the expanded source
+ * and the build options, so any change to them builds from source again.
  */
 class CLProgram
 {
 public:
+    /// Cache directory of the constructors, relative to the working directory
+    static constexpr const char* defaultCacheDir = "kernel_cache";
+
     /**
      * @brief Create program from source file
      * @param filePath Path to .cl source file
      * @param context OpenCL context
      * @param device OpenCL device
+     * @param buildOptions Compiler options, e.g. -D defines selecting a variant
+     * @param cacheDir Directory of the binary cache, empty always builds from source
      */
-    CLProgram(const std::string& filePath, cl::Context& context, cl::Device& device);
+    CLProgram(const std::string& filePath, cl::Context& context, cl::Device& device,
+              const std::string& buildOptions = "", const std::string& cacheDir = defaultCacheDir);
+
+    /**
+     * @brief Create program from source file for several devices of one context
+     * @param filePath Path to .cl source file
+     * @param context OpenCL context holding all devices
+     * @param devices Devices to build for
+     * @param buildOptions Compiler options, e.g. -D defines selecting a variant
+     * @param cacheDir Directory of the binary cache, empty always builds from source
+     */
+    CLProgram(const std::string& filePath, cl::Context& context, const std::vector<cl::Device>& devices,
+              const std::string& buildOptions = "", const std::string& cacheDir = defaultCacheDir);
     ~CLProgram() = default;
 
     // Disable copy, allow move
@@ -30,7 +52,15 @@ public:
     cl::Program& getProgram() { return m_program; }
     const cl::Program& getProgram() const { return m_program; }
 
+    /// Whether the program was created from cached binaries instead of the source
+    bool loadedFromCache() const { return m_fromCache; }
+
 private:
+    bool loadBinaries(const std::string& cachePath, cl::Context& context, const std::vector<cl::Device>& devices,
+                      const std::string& buildOptions);
+    void saveBinaries(const std::string& cachePath, size_t deviceCount) const;
+
+    bool m_fromCache = false;
     cl::Program m_program;
 };
 
@@ -0,0 +1,21 @@
+#include "cl_program_cache.h"
+
+namespace Compute {
+
+CLProgramCache::CLProgramCache(const cl::Context& context, const cl::Device& device)
+    : m_context(context)
+    , m_device(device)
+{
+}
+
+CLProgram& CLProgramCache::get(const std::string& filePath, const std::string& buildOptions)
+{
+    std::unique_ptr<CLProgram>& program = m_programs[{ filePath, buildOptions }];
+    if (!program)
+    {
+        program = std::make_unique<CLProgram>(filePath, m_context, m_device, buildOptions);
+    }
+    return *program;
+}
+
+} // namespace Compute
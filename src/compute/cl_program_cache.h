@@ -0,0 +1,58 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "cl_program.h"
+
+namespace Compute {
+
+/**
+ * @brief Programs built from one context and device, kept per source file and build options
+ *
+ * Variants selected by -D defines are compiled the first time they are asked
+ * for and returned from the cache afterwards, e.g. when a restart goes back
+ * to a maze size that was already used.
+ */
+class CLProgramCache
+{
+public:
+    /**
+     * @brief Create an empty cache
+     * @param context OpenCL context the programs are built for
+     * @param device OpenCL device the programs are built for
+     */
+    CLProgramCache(const cl::Context& context, const cl::Device& device);
+    ~CLProgramCache() = default;
+
+    // Disable copy, allow move
+    CLProgramCache(const CLProgramCache&) = delete;
+    CLProgramCache& operator=(const CLProgramCache&) = delete;
+    CLProgramCache(CLProgramCache&&) = default;
+    CLProgramCache& operator=(CLProgramCache&&) = default;
+
+    /**
+     * @brief Get the program of a source file built with the given options, building it if needed
+     * @param filePath Path to .cl source file
+     * @param buildOptions Compiler options, part of the cache key
+     * @return Program owned by the cache, valid until clear
+     */
+    CLProgram& get(const std::string& filePath, const std::string& buildOptions = "");
+
+    size_t size() const { return m_programs.size(); }
+
+    /**
+     * @brief Release all programs
+     */
+    void clear() { m_programs.clear(); }
+
+private:
+    cl::Context m_context;
+    cl::Device m_device;
+    std::map<std::pair<std::string, std::string>, std::unique_ptr<CLProgram>> m_programs;
+};
+
+} // namespace Compute
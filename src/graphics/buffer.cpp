@@ -15,6 +15,12 @@ void SSBO::update(size_t size, void* data)
     glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
 }
 
+void SSBO::updateRange(size_t offset, size_t size, const void* data)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
+
 void SSBO::bind(int binding)
 {
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_id);
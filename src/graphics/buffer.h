@@ -21,6 +21,7 @@ public:
     SSBO& operator=(SSBO&&) = default;
 
     void update(size_t size, void* data);
+    void updateRange(size_t offset, size_t size, const void* data); // keeps the allocation
     void bind(int binding);
     
     GLuint getID() const { return m_id; }
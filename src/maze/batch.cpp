@@ -0,0 +1,292 @@
+#include "batch.h"
+#include "maze.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace Maze {
+
+bool initializeBatchState(
+    const Compute::CLContext& clContext,
+    const Compute::CLProgram& clProgram,
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    const std::vector<Query>& queries,
+    BatchState& batchState
+)
+{
+    auto& st = batchState;
+
+    st.width = mazeWidth;
+    st.height = mazeHeight;
+    st.cells = layout_cells(st.layout, mazeWidth, mazeHeight);
+    st.queryCount = static_cast<int>(queries.size());
+    if (queries.empty())
+        return false;
+
+    // A group has to fit its tagged entries into an int and its distance slices into one allocation
+    const uint64_t maxAlloc = clContext.getDevice().getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    const int64_t slicesPerTag = std::numeric_limits<int32_t>::max() / st.cells;
+    const int64_t slicesPerAlloc = static_cast<int64_t>(maxAlloc / (sizeof(int32_t) * st.cells));
+    st.groupSize = static_cast<int>(std::min<int64_t>({ st.queryCount, slicesPerTag, slicesPerAlloc }));
+    if (st.groupSize < 1)
+    {
+        std::cerr << "A distance field of a " << mazeWidth << "x" << mazeHeight
+                  << " maze does not fit into one device buffer." << std::endl;
+        return false;
+    }
+    st.groupBegin = 0;
+    st.groupCount = 0;
+
+    // Same per query bound as a single run, the lists never hold more than every query's cells
+    const int maxWfSize = 2 * (std::max(mazeWidth, mazeHeight) - 1);
+    st.wfCapacity = static_cast<int>(std::min<int64_t>(
+        static_cast<int64_t>(st.groupSize) * 4 * maxWfSize,
+        static_cast<int64_t>(st.groupSize) * st.cells));
+
+    st.starts.clear();
+    st.targets.clear();
+    for (const Query& query : queries)
+    {
+        st.starts.push_back(deviceIndex(st.layout, mazeWidth, query.startIdx));
+        st.targets.push_back(query.targetIdx < 0 ? -1 : deviceIndex(st.layout, mazeWidth, query.targetIdx));
+    }
+    st.targetDist.assign(st.queryCount, -1);
+    st.groupDist.clear();
+
+    // Create OpenCL buffers, runBatch fills them group by group
+    const cl::Context& context = clContext.getContext();
+    st.cellBuf = createCellBuffer(context, hostMazeCosts, mazeWidth, mazeHeight, st.weighted, st.layout);
+    st.prevBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+    st.nextBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+    st.prevSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t));
+    st.nextSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t));
+    st.distBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * static_cast<size_t>(st.groupSize) * st.cells);
+    st.targetBuf = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(int32_t) * st.groupSize);
+    st.foundFlagBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(uint8_t) * st.groupSize);
+
+    st.kernel = cl::Kernel(clProgram.getProgram(), "expand_wave_batch");
+    st.rebuildKernel = cl::Kernel(clProgram.getProgram(), "rebuild_frontier_batch");
+    st.wfGrowths = 0;
+
+    if (st.groupSize < st.queryCount)
+    {
+        std::cout << "Batch of " << st.queryCount << " queries runs in groups of "
+                  << st.groupSize << " queries." << std::endl;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Put the queries [begin, begin + groupSize) on the device, every query starts with its start cell in the wavefront
+ * @return Size of the first wavefront
+ */
+static int32_t loadGroup(cl::CommandQueue& queue, BatchState& st, int begin)
+{
+    st.groupBegin = begin;
+    st.groupCount = std::min(st.groupSize, st.queryCount - begin);
+
+    std::vector<int32_t> prevHost;
+    st.foundFlagHost.assign(st.groupCount, 0);
+    for (int q = 0; q < st.groupCount; ++q)
+    {
+        const int start = st.starts[begin + q];
+        if (start == st.targets[begin + q])
+            st.foundFlagHost[q] = 1;
+        else
+            prevHost.push_back(q * st.cells + start);
+    }
+
+    // Host copies have to live until the blocking write below
+    const int32_t zero = 0;
+    const int32_t prevSize = static_cast<int32_t>(prevHost.size());
+    queue.enqueueFillBuffer(st.distBuf, int32_t(-1), 0, sizeof(int32_t) * static_cast<size_t>(st.groupCount) * st.cells);
+    for (int q = 0; q < st.groupCount; ++q)
+    {
+        const size_t offset = sizeof(int32_t) * (static_cast<size_t>(q) * st.cells + st.starts[begin + q]);
+        queue.enqueueWriteBuffer(st.distBuf, CL_FALSE, offset, sizeof(int32_t), &zero);
+    }
+    if (prevSize > 0)
+        queue.enqueueWriteBuffer(st.prevBuf, CL_FALSE, 0, sizeof(int32_t) * prevSize, prevHost.data());
+    queue.enqueueWriteBuffer(st.targetBuf, CL_FALSE, 0, sizeof(int32_t) * st.groupCount, st.targets.data() + begin);
+    queue.enqueueWriteBuffer(st.foundFlagBuf, CL_FALSE, 0, sizeof(uint8_t) * st.groupCount, st.foundFlagHost.data());
+    queue.enqueueFillBuffer(st.nextSizeBuf, 0, 0, sizeof(int32_t));
+    queue.enqueueWriteBuffer(st.prevSizeBuf, CL_TRUE, 0, sizeof(int32_t), &prevSize);
+
+    return prevSize;
+}
+
+static void setBatchArgs(BatchState& st)
+{
+    st.kernel.setArg(0, st.width);
+    st.kernel.setArg(1, st.height);
+    st.kernel.setArg(2, st.cellBuf);
+    st.kernel.setArg(3, st.prevBuf);
+    st.kernel.setArg(4, st.prevSizeBuf);
+    st.kernel.setArg(5, st.nextBuf);
+    st.kernel.setArg(6, st.nextSizeBuf);
+    st.kernel.setArg(7, st.wfCapacity);
+    st.kernel.setArg(8, st.distBuf);
+    st.kernel.setArg(9, st.targetBuf);
+    st.kernel.setArg(10, st.foundFlagBuf);
+}
+
+/**
+ * @brief Grow the shared wavefront lists after one overflowed and refill them from the distance slices
+ *
+ * expand_wave_batch stops touching the lists once one overflowed, the lost
+ * entries are still in the distances. Every entry q*N + idx is at most once
+ * in a rebuilt list, which bounds the capacity by the group's queries * cells.
+ */
+static void rebuildBatchFrontier(cl::CommandQueue& queue, BatchState& st, int32_t& wfSize)
+{
+    const cl::Context context = queue.getInfo<CL_QUEUE_CONTEXT>();
+    const int entries = st.groupCount * st.cells;
+    while (wfSize > st.wfCapacity)
+    {
+        const int64_t wanted = std::max<int64_t>(2ll * st.wfCapacity, wfSize);
+        st.wfCapacity = static_cast<int>(std::min<int64_t>(wanted, entries));
+        ++st.wfGrowths;
+
+        st.prevBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+        st.nextBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+        queue.enqueueFillBuffer(st.prevSizeBuf, 0, 0, sizeof(int32_t));
+
+        st.rebuildKernel.setArg(0, st.width);
+        st.rebuildKernel.setArg(1, st.height);
+        st.rebuildKernel.setArg(2, st.cellBuf);
+        st.rebuildKernel.setArg(3, st.distBuf);
+        st.rebuildKernel.setArg(4, st.prevBuf);
+        st.rebuildKernel.setArg(5, st.prevSizeBuf);
+        st.rebuildKernel.setArg(6, st.wfCapacity);
+        st.rebuildKernel.setArg(7, st.groupCount);
+        st.rebuildKernel.setArg(8, st.targetBuf);
+        st.rebuildKernel.setArg(9, st.foundFlagBuf);
+        queue.enqueueNDRangeKernel(st.rebuildKernel, cl::NullRange, cl::NDRange(entries), cl::NullRange);
+
+        queue.enqueueReadBuffer(st.prevSizeBuf, CL_TRUE, 0, sizeof(int32_t), &wfSize);
+    }
+
+    std::cout << "Batch wavefront overflowed, lists grown to " << st.wfCapacity << " entries" << std::endl;
+}
+
+/**
+ * @brief Run the group in distBuf to completion
+ * @return Number of steps
+ */
+static int runGroup(cl::CommandQueue& queue, BatchState& st, int32_t wfSize, int syncInterval)
+{
+    int wfBound = std::min(wfSize, st.wfCapacity);
+    int steps = 0;
+
+    while (wfSize > 0)
+    {
+        queue.enqueueFillBuffer(st.nextSizeBuf, 0, 0, sizeof(int32_t));
+        setBatchArgs(st);
+        queue.enqueueNDRangeKernel(st.kernel, cl::NullRange, cl::NDRange(wfBound), cl::NullRange);
+
+        std::swap(st.prevBuf, st.nextBuf);
+        std::swap(st.prevSizeBuf, st.nextSizeBuf);
+
+        ++steps;
+        wfBound = static_cast<int>(std::min<int64_t>(4ll * wfBound, st.wfCapacity));
+
+        if (steps % syncInterval != 0)
+            continue;
+
+        // Sync point
+        queue.enqueueReadBuffer(st.foundFlagBuf, CL_FALSE, 0, sizeof(uint8_t) * st.foundFlagHost.size(), st.foundFlagHost.data());
+        queue.enqueueReadBuffer(st.prevSizeBuf, CL_TRUE, 0, sizeof(int32_t), &wfSize);
+
+        // Entries past the capacity were dropped, the steps after them did nothing
+        if (wfSize > st.wfCapacity)
+            rebuildBatchFrontier(queue, st, wfSize);
+        wfBound = std::min(wfSize, st.wfCapacity);
+
+        // Uniform queries are done when their target is reached
+        if (!st.weighted && std::all_of(st.foundFlagHost.begin(), st.foundFlagHost.end(), [](uint8_t f) { return f != 0; }))
+            break;
+    }
+
+    for (int q = 0; q < st.groupCount; ++q)
+    {
+        const int32_t target = st.targets[st.groupBegin + q];
+        if (target < 0)
+            continue;
+        const size_t offset = sizeof(int32_t) * (static_cast<size_t>(q) * st.cells + target);
+        queue.enqueueReadBuffer(st.distBuf, CL_FALSE, offset, sizeof(int32_t), &st.targetDist[st.groupBegin + q]);
+    }
+    queue.finish();
+
+    return steps;
+}
+
+int runBatch(
+    cl::CommandQueue& queue,
+    BatchState& batchState,
+    int syncInterval
+)
+{
+    auto& st = batchState;
+    syncInterval = std::max(syncInterval, 1);
+
+    int steps = 0;
+    st.groupDist.clear();
+    for (int begin = 0; begin < st.queryCount; begin += st.groupSize)
+    {
+        // The next group reuses the buffers, keep the distances of this one on the host
+        if (begin > 0)
+        {
+            st.groupDist.resize(static_cast<size_t>(begin) * st.cells);
+            queue.enqueueReadBuffer(
+                st.distBuf,
+                CL_TRUE,
+                0,
+                sizeof(int32_t) * static_cast<size_t>(st.groupSize) * st.cells,
+                st.groupDist.data() + static_cast<size_t>(begin - st.groupSize) * st.cells
+            );
+        }
+
+        steps += runGroup(queue, st, loadGroup(queue, st, begin), syncInterval);
+    }
+
+    const int found = static_cast<int>(std::count_if(
+        st.targetDist.begin(), st.targetDist.end(), [](int32_t d) { return d >= 0; }));
+
+    std::cout << "Batch of " << st.queryCount << " queries finished after " << steps
+              << " steps, " << found << " targets reached." << std::endl;
+
+    return found;
+}
+
+void readBatchDistances(
+    cl::CommandQueue& queue,
+    const BatchState& batchState,
+    int query,
+    std::vector<int32_t>& dist
+)
+{
+    const auto& st = batchState;
+    std::vector<int32_t> slice(st.cells);
+    if (query < st.groupBegin)
+    {
+        // Finished with an earlier group
+        const auto first = st.groupDist.begin() + static_cast<size_t>(query) * st.cells;
+        std::copy(first, first + st.cells, slice.begin());
+    }
+    else
+    {
+        queue.enqueueReadBuffer(
+            st.distBuf,
+            CL_TRUE,
+            sizeof(int32_t) * static_cast<size_t>(query - st.groupBegin) * st.cells,
+            sizeof(int32_t) * st.cells,
+            slice.data()
+        );
+    }
+    fromDeviceLayout(slice, st.width, st.height, st.layout, dist);
+}
+
+} // namespace Maze
@@ -0,0 +1,126 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "../compute/cl_context.h"
+#include "../compute/cl_program.h"
+#include "shared/cell_layout.h"
+
+namespace Maze {
+
+/**
+ * @brief One (start, target) question against the maze of a batch,
+ * a target of -1 computes the whole distance field of the start
+ */
+struct Query {
+    int startIdx;
+    int targetIdx;
+};
+
+/**
+ * @brief Buffers of a multi-query run, all queries share the wavefront lists
+ *
+ * Wavefront entries are tagged as query*cells + storage index and all
+ * distance slices live in one buffer. Batches where queries * cells does not
+ * fit into an int or into one allocation run in groups of groupSize queries,
+ * one group after another on the same buffers.
+ */
+struct BatchState {
+    cl::Buffer cellBuf;
+    cl::Buffer prevBuf;
+    cl::Buffer nextBuf;
+    cl::Buffer prevSizeBuf;
+    cl::Buffer nextSizeBuf;
+    cl::Buffer distBuf;      /// one distance slice of `cells` ints per query of the group
+    cl::Buffer targetBuf;
+    cl::Buffer foundFlagBuf; /// one flag per query of the group
+
+    int width = 0;
+    int height = 0;
+    int cells = 0; /// cells of a distance slice, see layout_cells
+    int queryCount = 0;
+    int groupSize = 0;  /// queries on the device at a time
+    int groupBegin = 0; /// first query of the group in distBuf
+    int groupCount = 0; /// queries of the group in distBuf
+    int wfCapacity = 0; /// index slots shared by the queries of a group
+
+    /// Weighted batches prune each query by its target distance and run until
+    /// the shared wavefront is empty, set before initializeBatchState. Has to
+    /// match the program, it also selects the two byte cell encoding.
+    bool weighted = false;
+
+    /// Cell layout of the program, set before initializeBatchState
+    int layout = LAYOUT_ROW_MAJOR;
+
+    std::vector<int32_t> starts;  /// storage indices
+    std::vector<int32_t> targets; /// storage indices, -1 for full fields
+    std::vector<int32_t> groupDist; /// distance slices of the groups run before the one in distBuf
+    std::vector<uint8_t> foundFlagHost;
+    std::vector<int32_t> targetDist; /// per query, -1 if the target is unreachable
+    int wfGrowths = 0;               /// number of times the lists were grown in this run
+
+    cl::Kernel kernel;
+    cl::Kernel rebuildKernel;
+};
+
+/**
+ * @brief Create the buffers of a batch for its first group of queries
+ * @param clContext OpenCL context
+ * @param clProgram Uniform or weighted program, both provide expand_wave_batch
+ * @param hostMazeCosts Cell costs, negative for walls
+ * @param mazeWidth Maze width
+ * @param mazeHeight Maze height
+ * @param queries Start and target of every query
+ * @param batchState State to fill
+ * @return false if the batch is empty or a single distance slice does not fit
+ */
+bool initializeBatchState(
+    const Compute::CLContext& clContext,
+    const Compute::CLProgram& clProgram,
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    const std::vector<Query>& queries,
+    BatchState& batchState
+);
+
+/**
+ * @brief Run all queries of a batch to completion
+ *
+ * Every step is a single launch over the shared wavefront. The host only
+ * syncs every syncInterval steps and reads the target distances at the end.
+ * A sync point that finds the shared wavefront overflowed grows the lists and
+ * refills them from the distance slices like rebuildFrontier, so the
+ * distances are exact whatever the sync interval. Groups run one after
+ * another, the distances of finished groups are kept on the host.
+ *
+ * @param queue OpenCL command queue
+ * @param batchState State created by initializeBatchState
+ * @param syncInterval Number of steps between two host synchronizations
+ * @return Number of queries whose target was reached, queries without a target do not count
+ */
+int runBatch(
+    cl::CommandQueue& queue,
+    BatchState& batchState,
+    int syncInterval
+);
+
+/**
+ * @brief Read the distance field of one query, e.g. for extractPath
+ * @param queue OpenCL command queue
+ * @param batchState State of a finished batch
+ * @param query Index of the query
+ * @param dist Receives width * height distances in row-major order
+ */
+void readBatchDistances(
+    cl::CommandQueue& queue,
+    const BatchState& batchState,
+    int query,
+    std::vector<int32_t>& dist
+);
+
+} // namespace Maze
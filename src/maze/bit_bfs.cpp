@@ -0,0 +1,458 @@
+#include "bit_bfs.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace Maze {
+
+/// Rows a column sweeps per wavefront run before the runs are merged instead
+static constexpr int denseRowsPerRun = 32;
+
+/// Wavefront cells above which a level is expanded on the bit planes
+static constexpr int denseFrontier = 1024;
+
+static inline int countTrailingZeros(uint64_t bits)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, bits);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+const char* bitBfsInstructionSet()
+{
+#if defined(__AVX512F__)
+    return "AVX-512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#else
+    return "scalar";
+#endif
+}
+
+bool initializeBitBfsState(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth, int mazeHeight, int startIndex,
+    BitBfsState& bitState
+)
+{
+    auto& st = bitState;
+
+    st.wordCols = (mazeWidth + 63) / 64 + 2;
+    st.rowStride = mazeHeight + 2;
+
+    const size_t words = static_cast<size_t>(st.wordCols) * st.rowStride;
+    st.open.assign(words, 0);
+    st.visited.assign(words, 0);
+    st.frontier.assign(words, 0);
+    st.next.assign(words, 0);
+    st.dist.assign(static_cast<size_t>(mazeWidth) * mazeHeight, -1);
+    st.level = 0;
+
+    st.active.clear();
+    st.nextActive.clear();
+
+    auto bitOf = [&](int idx, size_t& word) {
+        const int x = idx % mazeWidth;
+        const int y = idx / mazeWidth;
+        word = static_cast<size_t>(x / 64 + 1) * st.rowStride + (y + 1);
+        return uint64_t(1) << (x % 64);
+    };
+
+    size_t word;
+    for (int idx = 0; idx < mazeWidth * mazeHeight; ++idx)
+    {
+        if (hostMazeCosts[idx] >= 0)
+        {
+            const uint64_t bit = bitOf(idx, word);
+            st.open[word] |= bit;
+        }
+    }
+
+    // A single cell is a sparse wavefront
+    const uint64_t startBit = bitOf(startIndex, word);
+    st.visited[word] |= startBit;
+    st.dist[startIndex] = 0;
+    st.sparse = true;
+    st.cellFront.assign(1, { startIndex % mazeWidth, startIndex / mazeWidth });
+    st.nextCellFront.clear();
+
+    std::cout << "Bit-parallel BFS uses " << bitBfsInstructionSet() << std::endl;
+    return true;
+}
+
+/**
+ * @brief Write the level of every cell set in a word of the next wavefront
+ * @return Number of cells in the word
+ */
+static int emitWord(uint64_t bits, int w, int r, int width, int level, BitBfsState& st)
+{
+    if (!bits)
+        return 0;
+
+    st.nextActive.push_back(static_cast<uint32_t>(w * st.rowStride + r));
+
+    const int base = (r - 1) * width + (w - 1) * 64;
+    int count = 0;
+    while (bits)
+    {
+        st.dist[base + countTrailingZeros(bits)] = level;
+        bits &= bits - 1;
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief Expand the wavefront into rows [lo, hi] of a word column
+ * @return Number of cells reached
+ */
+static int sweepRows(int w, int lo, int hi, int width, int level, BitBfsState& st)
+{
+    const uint64_t* F = st.frontier.data();
+    const uint64_t* O = st.open.data();
+    uint64_t* V = st.visited.data();
+    uint64_t* N = st.next.data();
+    const size_t RS = st.rowStride;
+
+    const size_t col = w * RS;
+    const size_t left = col - RS;
+    const size_t right = col + RS;
+    int r = lo;
+    int count = 0;
+
+    // Bit x of a word is the cell at column 64*w + x: the left neighbor
+    // moves up by one bit, the right one down, with carries across words
+#if defined(__AVX512F__)
+    for (; r + 7 <= hi; r += 8)
+    {
+        const size_t i = col + r;
+        const __m512i f = _mm512_loadu_si512(F + i);
+        __m512i n = _mm512_or_si512(_mm512_slli_epi64(f, 1), _mm512_srli_epi64(f, 1));
+        n = _mm512_or_si512(n, _mm512_srli_epi64(_mm512_loadu_si512(F + left + r), 63));
+        n = _mm512_or_si512(n, _mm512_slli_epi64(_mm512_loadu_si512(F + right + r), 63));
+        n = _mm512_or_si512(n, _mm512_loadu_si512(F + i - 1));
+        n = _mm512_or_si512(n, _mm512_loadu_si512(F + i + 1));
+
+        const __m512i v = _mm512_loadu_si512(V + i);
+        n = _mm512_andnot_si512(v, _mm512_and_si512(n, _mm512_loadu_si512(O + i)));
+        _mm512_storeu_si512(N + i, n);
+        _mm512_storeu_si512(V + i, _mm512_or_si512(v, n));
+
+        if (_mm512_test_epi64_mask(n, n))
+        {
+            for (int l = 0; l < 8; ++l)
+                count += emitWord(N[i + l], w, r + l, width, level, st);
+        }
+    }
+#elif defined(__AVX2__)
+    for (; r + 3 <= hi; r += 4)
+    {
+        const size_t i = col + r;
+        const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i));
+        __m256i n = _mm256_or_si256(_mm256_slli_epi64(f, 1), _mm256_srli_epi64(f, 1));
+        n = _mm256_or_si256(n, _mm256_srli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + left + r)), 63));
+        n = _mm256_or_si256(n, _mm256_slli_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + right + r)), 63));
+        n = _mm256_or_si256(n, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i - 1)));
+        n = _mm256_or_si256(n, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(F + i + 1)));
+
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(V + i));
+        n = _mm256_andnot_si256(v, _mm256_and_si256(n, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(O + i))));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(N + i), n);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(V + i), _mm256_or_si256(v, n));
+
+        if (!_mm256_testz_si256(n, n))
+        {
+            for (int l = 0; l < 4; ++l)
+                count += emitWord(N[i + l], w, r + l, width, level, st);
+        }
+    }
+#endif
+    // Scalar fallback and the rows left over by the vector loop
+    for (; r <= hi; ++r)
+    {
+        const size_t i = col + r;
+        const uint64_t f = F[i];
+        uint64_t n = (f << 1) | (F[left + r] >> 63) | (f >> 1) | (F[right + r] << 63) | F[i - 1] | F[i + 1];
+        n &= O[i] & ~V[i];
+        N[i] = n;
+        V[i] |= n;
+
+        count += emitWord(n, w, r, width, level, st);
+    }
+    return count;
+}
+
+/**
+ * @brief Expand a dense wavefront by one level on the bit planes
+ * @return Size of the new wavefront
+ */
+static int expandDense(int width, int height, BitBfsState& st)
+{
+    const int level = st.level + 1;
+    const size_t RS = st.rowStride;
+
+    // The active words are in plane order. Group adjacent rows into runs and
+    // find where the runs of each word column start.
+    st.activeRuns.clear();
+    for (uint32_t word : st.active)
+    {
+        if (!st.activeRuns.empty() && st.activeRuns.back().second + 1 == word)
+            st.activeRuns.back().second = word;
+        else
+            st.activeRuns.emplace_back(word, word);
+    }
+    st.columnStart.assign(st.wordCols + 1, 0);
+    for (const auto& run : st.activeRuns)
+        ++st.columnStart[run.first / RS + 1];
+    for (int w = 0; w < st.wordCols; ++w)
+        st.columnStart[w + 1] += st.columnStart[w];
+
+    const auto* runs = st.activeRuns.data();
+    auto first = [&](int i) { return static_cast<int>(runs[i].first % RS); };
+    auto last = [&](int i) { return static_cast<int>(runs[i].second % RS); };
+
+    st.nextActive.clear();
+    int count = 0;
+    for (int w = 1; w < st.wordCols - 1; ++w)
+    {
+        // Cells can only be reached from wavefront words one row or word column
+        // away. Merge the runs of this and the adjacent word columns, in order,
+        // into runs of adjacent rows the vector loops can take.
+        int l = st.columnStart[w - 1];
+        int m = st.columnStart[w];
+        int r = st.columnStart[w + 1];
+        const int lEnd = st.columnStart[w];
+        const int mEnd = st.columnStart[w + 1];
+        const int rEnd = st.columnStart[w + 2];
+
+        const int runCount = (lEnd - l) + (mEnd - m) + (rEnd - r);
+        if (runCount == 0)
+            continue;
+
+        // Dense columns are cheaper to sweep in one range, the merge only
+        // pays off where few runs are spread over many rows. Either way a
+        // column costs at most denseRowsPerRun rows per run.
+        int spanLo = height + 2;
+        int spanHi = 0;
+        if (l < lEnd) { spanLo = std::min(spanLo, first(l)); spanHi = std::max(spanHi, last(lEnd - 1)); }
+        if (m < mEnd) { spanLo = std::min(spanLo, first(m) - 1); spanHi = std::max(spanHi, last(mEnd - 1) + 1); }
+        if (r < rEnd) { spanLo = std::min(spanLo, first(r)); spanHi = std::max(spanHi, last(rEnd - 1)); }
+        spanLo = std::max(spanLo, 1);
+        spanHi = std::min(spanHi, height);
+        if (spanHi - spanLo + 1 <= denseRowsPerRun * runCount)
+        {
+            count += sweepRows(w, spanLo, spanHi, width, level, st);
+            continue;
+        }
+
+        int sweepLo = 0;
+        int sweepHi = -1;
+        while (l < lEnd || m < mEnd || r < rEnd)
+        {
+            int lo = height + 2;
+            int hi = 0;
+            if (l < lEnd && first(l) < lo) { lo = first(l); hi = last(l); }
+            if (m < mEnd && first(m) - 1 < lo) { lo = first(m) - 1; hi = last(m) + 1; }
+            if (r < rEnd && first(r) < lo) { lo = first(r); hi = last(r); }
+
+            if (l < lEnd && first(l) == lo) ++l;
+            else if (m < mEnd && first(m) - 1 == lo) ++m;
+            else ++r;
+
+            lo = std::max(lo, 1);
+            hi = std::min(hi, height);
+            if (lo > sweepHi + 1)
+            {
+                if (sweepLo <= sweepHi)
+                    count += sweepRows(w, sweepLo, sweepHi, width, level, st);
+                sweepLo = lo;
+            }
+            sweepHi = std::max(sweepHi, hi);
+        }
+        if (sweepLo <= sweepHi)
+            count += sweepRows(w, sweepLo, sweepHi, width, level, st);
+    }
+
+    // Clear the old wavefront, its buffer receives the next one
+    uint64_t* oldFrontier = st.frontier.data();
+    for (uint32_t word : st.active)
+        oldFrontier[word] = 0;
+
+    std::swap(st.frontier, st.next);
+    std::swap(st.active, st.nextActive);
+    st.level = level;
+    return count;
+}
+
+/**
+ * @brief Expand a sparse wavefront by one level, cell by cell
+ *
+ * Neighbors are looked up in the bit planes, the padding words are never
+ * open, so cells on the border need no bounds checks either.
+ *
+ * @return Size of the new wavefront
+ */
+static int expandSparse(int width, BitBfsState& st)
+{
+    const uint64_t* O = st.open.data();
+    uint64_t* V = st.visited.data();
+    const size_t RS = st.rowStride;
+    const int level = st.level + 1;
+
+    auto visit = [&](int x, int y) {
+        const size_t i = static_cast<size_t>((x >> 6) + 1) * RS + (y + 1);
+        const uint64_t bit = uint64_t(1) << (x & 63);
+        if (!(O[i] & bit) || (V[i] & bit))
+            return;
+        V[i] |= bit;
+        st.dist[static_cast<size_t>(y) * width + x] = level;
+        st.nextCellFront.push_back({ x, y });
+    };
+
+    st.nextCellFront.clear();
+    for (const auto& cell : st.cellFront)
+    {
+        const int x = cell.first;
+        const int y = cell.second;
+        visit(x - 1, y);
+        visit(x + 1, y);
+        visit(x, y - 1);
+        visit(x, y + 1);
+    }
+
+    std::swap(st.cellFront, st.nextCellFront);
+    st.level = level;
+    return static_cast<int>(st.cellFront.size());
+}
+
+/**
+ * @brief Move a sparse wavefront into the frontier plane
+ */
+static void toDense(BitBfsState& st)
+{
+    st.active.clear();
+    for (const auto& cell : st.cellFront)
+    {
+        const int x = cell.first;
+        const int y = cell.second;
+        const uint32_t word = static_cast<uint32_t>((x / 64 + 1) * st.rowStride + (y + 1));
+        st.frontier[word] |= uint64_t(1) << (x % 64);
+        st.active.push_back(word);
+    }
+    // The sweep expects the active words in plane order
+    std::sort(st.active.begin(), st.active.end());
+    st.active.erase(std::unique(st.active.begin(), st.active.end()), st.active.end());
+    st.cellFront.clear();
+    st.sparse = false;
+}
+
+/**
+ * @brief Move a dense wavefront out of the frontier plane into a cell list
+ */
+static void toSparse(BitBfsState& st)
+{
+    const size_t RS = st.rowStride;
+    st.cellFront.clear();
+    for (uint32_t word : st.active)
+    {
+        const int x = static_cast<int>(word / RS - 1) * 64;
+        const int y = static_cast<int>(word % RS - 1);
+        for (uint64_t bits = st.frontier[word]; bits; bits &= bits - 1)
+            st.cellFront.push_back({ x + countTrailingZeros(bits), y });
+        st.frontier[word] = 0;
+    }
+    st.active.clear();
+    st.sparse = true;
+}
+
+/**
+ * @brief Expand the wavefront by one level
+ *
+ * Thin wavefronts, the corridors of perfect mazes, are cheaper to expand cell
+ * by cell than to sweep even a few words per cell. A wavefront that grows past
+ * denseFrontier cells moves to the bit planes, one that shrinks below half of
+ * it moves back.
+ *
+ * @return Size of the new wavefront
+ */
+static int expandLevel(int width, int height, BitBfsState& st)
+{
+    if (st.sparse)
+    {
+        const int count = expandSparse(width, st);
+        if (count > denseFrontier)
+            toDense(st);
+        return count;
+    }
+
+    const int count = expandDense(width, height, st);
+    if (count < denseFrontier / 2)
+        toSparse(st);
+    return count;
+}
+
+bool stepBitBfs(
+    int step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    BitBfsState& bitState
+)
+{
+    auto& st = bitState;
+
+    if (currentWfSize == 0)
+        return false;
+
+    currentWfSize = expandLevel(width, height, st);
+
+    if (st.dist[targetIdx] >= 0)
+    {
+        std::cout << "Target found at step " << step << std::endl;
+        return true;
+    }
+
+    if (currentWfSize == 0)
+    {
+        std::cout << "No more cells to expand - path not found." << std::endl;
+        return false;
+    }
+
+    return false;
+}
+
+bool runBitBfs(
+    int& step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    BitBfsState& bitState,
+    int maxSteps
+)
+{
+    for (int done = 0; currentWfSize > 0 && (maxSteps <= 0 || done < maxSteps); ++done)
+    {
+        const bool found = stepBitBfs(step, width, height, currentWfSize, targetIdx, bitState);
+        ++step;
+        if (found)
+            return true;
+    }
+
+    return false;
+}
+
+} // namespace Maze
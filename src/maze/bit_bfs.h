@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Maze {
+
+/**
+ * @brief State of the bit-parallel BFS for uniform costs
+ *
+ * Open cells, visited cells and the wavefront are packed bit planes. A plane
+ * is stored word column by word column: the 64-bit words of all rows for
+ * columns [0, 64) come first, then those for [64, 128) and so on. The rows
+ * of a column are contiguous, so up/down neighbors are the words at r-1 and
+ * r+1. Left/right neighbors are shifts plus the carry bit from the adjacent
+ * word column. One padding row and one padding word column on every side
+ * keep the expansion free of bounds checks. The non-zero words of the
+ * wavefront are kept in a list, so a step only touches the words around
+ * them and its cost follows the wavefront instead of the maze. Thin
+ * wavefronts, as in the corridors of perfect mazes, skip the frontier plane
+ * and are expanded cell by cell against the open and visited planes.
+ *
+ * Built with AVX2 or AVX-512 the expansion handles runs of 4 or 8 adjacent
+ * rows per instruction, otherwise it falls back to one word at a time.
+ */
+struct BitBfsState {
+    int wordCols = 0;  /// word columns including the padding
+    int rowStride = 0; /// words per word column including the padding
+
+    std::vector<uint64_t> open;
+    std::vector<uint64_t> visited;
+    std::vector<uint64_t> frontier;
+    std::vector<uint64_t> next;
+
+    /// Plane indices of the non-zero wavefront words. A step only sweeps
+    /// these words and their neighbors in the adjacent rows and word columns.
+    std::vector<uint32_t> active;
+    std::vector<uint32_t> nextActive;
+    std::vector<std::pair<uint32_t, uint32_t>> activeRuns; /// first and last word of adjacent active rows
+    std::vector<int> columnStart; /// first run of each word column, one past the end at the back
+
+    /// Thin wavefronts are kept as (x, y) cells instead of frontier words
+    bool sparse = true;
+    std::vector<std::pair<int, int>> cellFront;
+    std::vector<std::pair<int, int>> nextCellFront;
+
+    std::vector<int32_t> dist; /// step numbers in the row-major layout the shader reads
+    int level = 0;
+};
+
+/**
+ * @brief Name of the instruction set the expansion was built for
+ */
+const char* bitBfsInstructionSet();
+
+/**
+ * @brief Pack the maze into bit planes and put the start cell into the wavefront
+ * @param hostMazeCosts Cell costs, negative for walls, the values of open cells are ignored
+ * @param mazeWidth Maze width
+ * @param mazeHeight Maze height
+ * @param startIndex Start cell index
+ * @param bitState State to fill
+ * @return true on success
+ */
+bool initializeBitBfsState(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth, int mazeHeight, int startIndex,
+    BitBfsState& bitState
+);
+
+/**
+ * @brief Execute one BFS level on the bit planes
+ * @param step Current step number
+ * @param width Maze width
+ * @param height Maze height
+ * @param currentWfSize Current wavefront size (will be updated)
+ * @param targetIdx Target cell index
+ * @param bitState State of the run
+ * @return true if target found, false otherwise
+ */
+bool stepBitBfs(
+    int step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    BitBfsState& bitState
+);
+
+/**
+ * @brief Execute several BFS levels, the counterpart of runPathfinding
+ * @param step Current step number, advanced by the steps run
+ * @param width Maze width
+ * @param height Maze height
+ * @param currentWfSize Current wavefront size (will be updated)
+ * @param targetIdx Target cell index
+ * @param bitState State of the run
+ * @param maxSteps Maximum number of steps, 0 runs until the search is over
+ * @return true if target found, false otherwise
+ */
+bool runBitBfs(
+    int& step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    BitBfsState& bitState,
+    int maxSteps
+);
+
+} // namespace Maze
@@ -0,0 +1,204 @@
+#include "cpu_solver.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace Maze {
+
+bool initializeCpuMazeState(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth, int mazeHeight, int startIndex,
+    CpuMazeState& cpuState
+)
+{
+    auto& st = cpuState;
+
+    if (!st.pool || (st.threadCount != 0 && st.pool->size() != st.threadCount))
+        st.pool = std::make_unique<Utils::ThreadPool>(st.threadCount);
+
+    st.costs = hostMazeCosts;
+    st.cells = mazeWidth * mazeHeight;
+    st.dist = std::make_unique<std::atomic<int32_t>[]>(st.cells);
+    for (int i = 0; i < st.cells; ++i)
+        st.dist[i].store(-1, std::memory_order_relaxed);
+    st.dist[startIndex].store(0, std::memory_order_relaxed);
+
+    st.frontier.assign(1, startIndex);
+    st.localNext.assign(st.pool->size(), {});
+    st.found.store(0);
+    st.targetDist = -1;
+
+    return true;
+}
+
+/**
+ * @brief Lower dist[j] to newDist, returns true if this call improved it
+ */
+static bool relaxDist(std::atomic<int32_t>& dist, int32_t newDist)
+{
+    int32_t old = dist.load(std::memory_order_relaxed);
+    while (old == -1 || newDist < old)
+    {
+        if (dist.compare_exchange_weak(old, newDist, std::memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Expand the wavefront entries [begin, end) into the local next wavefront of a worker
+ */
+static void expandRange(size_t begin, size_t end, int width, int height, int targetIdx, std::vector<int32_t>& out, CpuMazeState& st)
+{
+    // Uniform steps queued after the target was found have nothing to do
+    if (!st.weighted && st.found.load(std::memory_order_relaxed))
+        return;
+
+    const int32_t targetDist = st.dist[targetIdx].load(std::memory_order_relaxed);
+    const int32_t bound = (st.weighted && targetDist >= 0) ? targetDist : std::numeric_limits<int32_t>::max();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const int idx = st.frontier[i];
+        const int32_t dcurr = st.dist[idx].load(std::memory_order_relaxed);
+        if (dcurr >= bound)
+            continue;
+
+        const int x = idx % width;
+        const int y = idx / width;
+
+        for (int k = 0; k < 4; ++k)
+        {
+            const int nx = x + ((k == 0) ? -1 : (k == 1) ? 1 : 0);
+            const int ny = y + ((k == 2) ? -1 : (k == 3) ? 1 : 0);
+
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                continue;
+
+            const int j = ny * width + nx;
+
+            // Skip walls
+            if (st.costs[j] < 0)
+                continue;
+
+            bool improved;
+            if (st.weighted)
+            {
+                const int32_t newDist = dcurr + st.costs[j];
+                improved = newDist < bound && relaxDist(st.dist[j], newDist);
+            }
+            else
+            {
+                int32_t expected = -1;
+                improved = st.dist[j].compare_exchange_strong(expected, dcurr + 1, std::memory_order_relaxed);
+            }
+
+            if (!improved)
+                continue;
+
+            // The target is never expanded, like in the kernels
+            if (j == targetIdx)
+            {
+                st.found.store(1, std::memory_order_relaxed);
+                continue;
+            }
+            out.push_back(j);
+        }
+    }
+}
+
+/**
+ * @brief Expand the whole wavefront and gather the local next wavefronts
+ */
+static void expandStep(int width, int height, int targetIdx, CpuMazeState& st)
+{
+    st.pool->parallelFor(st.frontier.size(), 256, [&](size_t begin, size_t end, unsigned worker)
+    {
+        expandRange(begin, end, width, height, targetIdx, st.localNext[worker], st);
+    });
+
+    std::vector<size_t> offsets(st.localNext.size() + 1, 0);
+    for (size_t w = 0; w < st.localNext.size(); ++w)
+        offsets[w + 1] = offsets[w] + st.localNext[w].size();
+
+    // Small wavefronts are not worth waking the pool for
+    st.frontier.resize(offsets.back());
+    const size_t grain = offsets.back() < 4096 ? st.localNext.size() : 1;
+    st.pool->parallelFor(st.localNext.size(), grain, [&](size_t begin, size_t end, unsigned)
+    {
+        for (size_t w = begin; w < end; ++w)
+        {
+            std::copy(st.localNext[w].begin(), st.localNext[w].end(), st.frontier.begin() + offsets[w]);
+            st.localNext[w].clear();
+        }
+    });
+}
+
+bool stepPathfindingCpu(
+    int step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    CpuMazeState& cpuState
+)
+{
+    auto& st = cpuState;
+
+    if (currentWfSize == 0)
+        return false;
+
+    expandStep(width, height, targetIdx, st);
+    currentWfSize = static_cast<int>(st.frontier.size());
+    st.targetDist = st.dist[targetIdx].load();
+
+    const bool found = st.found.load() != 0;
+    if (!st.weighted && found)
+    {
+        std::cout << "Target found at step " << step << std::endl;
+        return true;
+    }
+
+    if (currentWfSize != 0)
+        return false;
+
+    if (found)
+    {
+        std::cout << "Target found at step " << step << " with distance " << st.targetDist << std::endl;
+        return true;
+    }
+
+    std::cout << "No more cells to expand - path not found." << std::endl;
+    return false;
+}
+
+bool runPathfindingCpu(
+    int& step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    CpuMazeState& cpuState,
+    int maxSteps
+)
+{
+    // There is no sync to amortize, every step sees its exact wavefront
+    for (int done = 0; currentWfSize > 0 && (maxSteps <= 0 || done < maxSteps); ++done)
+    {
+        const bool found = stepPathfindingCpu(step, width, height, currentWfSize, targetIdx, cpuState);
+        ++step;
+        if (found)
+            return true;
+    }
+
+    return false;
+}
+
+void copyDistances(const CpuMazeState& cpuState, std::vector<int32_t>& dist)
+{
+    dist.resize(cpuState.cells);
+    for (int i = 0; i < cpuState.cells; ++i)
+        dist[i] = cpuState.dist[i].load(std::memory_order_relaxed);
+}
+
+} // namespace Maze
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+
+namespace Maze {
+
+/**
+ * @brief State of the native solver, the CPU counterpart of MazeState
+ *
+ * Each step expands the wavefront in parallel on a work stealing thread
+ * pool, every worker appends to its own local next wavefront and the locals
+ * are concatenated at the end of the step. Needs neither OpenCL nor GL.
+ */
+struct CpuMazeState {
+    std::vector<int32_t> costs;
+    std::unique_ptr<std::atomic<int32_t>[]> dist;
+    int cells = 0;
+
+    std::vector<int32_t> frontier;
+    std::vector<std::vector<int32_t>> localNext; /// one next wavefront per worker
+
+    /// Same semantics as MazeState::weighted, set before initializeCpuMazeState
+    bool weighted = false;
+    unsigned threadCount = 0; /// 0 uses all cores
+
+    std::atomic<uint8_t> found{0};
+    int32_t targetDist = -1;
+
+    std::unique_ptr<Utils::ThreadPool> pool;
+};
+
+/**
+ * @brief Reset the native solver for a new run, the thread pool is kept across runs
+ * @param hostMazeCosts Cell costs, negative for walls
+ * @param mazeWidth Maze width
+ * @param mazeHeight Maze height
+ * @param startIndex Start cell index
+ * @param cpuState State to fill
+ * @return true on success
+ */
+bool initializeCpuMazeState(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth, int mazeHeight, int startIndex,
+    CpuMazeState& cpuState
+);
+
+/**
+ * @brief Execute one step of wavefront pathfinding on the CPU
+ *
+ * Same contract as stepPathfinding: uniform runs stop at the target, weighted
+ * runs continue until no wavefront entry can lower the target distance.
+ *
+ * @param step Current step number
+ * @param width Maze width
+ * @param height Maze height
+ * @param currentWfSize Current wavefront size (will be updated)
+ * @param targetIdx Target cell index
+ * @param cpuState State of the run
+ * @return true if target found, false otherwise
+ */
+bool stepPathfindingCpu(
+    int step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    CpuMazeState& cpuState
+);
+
+/**
+ * @brief Execute several steps on the CPU, the counterpart of runPathfinding
+ * @param step Current step number, advanced by the steps run
+ * @param width Maze width
+ * @param height Maze height
+ * @param currentWfSize Current wavefront size (will be updated)
+ * @param targetIdx Target cell index
+ * @param cpuState State of the run
+ * @param maxSteps Maximum number of steps, 0 runs until the search is over
+ * @return true if target found, false otherwise
+ */
+bool runPathfindingCpu(
+    int& step,
+    int width,
+    int height,
+    int& currentWfSize,
+    int targetIdx,
+    CpuMazeState& cpuState,
+    int maxSteps
+);
+
+/**
+ * @brief Copy the current distances, e.g. for rendering or extractPath
+ */
+void copyDistances(const CpuMazeState& cpuState, std::vector<int32_t>& dist);
+
+} // namespace Maze
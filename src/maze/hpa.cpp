@@ -0,0 +1,478 @@
+#include "hpa.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+namespace Maze {
+
+namespace {
+
+/**
+ * @brief Cell bounds of a cluster, clusters on the last row and column can be smaller
+ */
+struct Box {
+    int x0, y0, w, h;
+
+    int local(int cell, int width) const
+    {
+        return (cell / width - y0) * w + cell % width - x0;
+    }
+};
+
+} // namespace
+
+static Box clusterBox(const HpaGraph& g, int cluster)
+{
+    const int x0 = (cluster % g.clustersX) * g.clusterSize;
+    const int y0 = (cluster / g.clustersX) * g.clusterSize;
+    return { x0, y0, std::min(g.clusterSize, g.width - x0), std::min(g.clusterSize, g.height - y0) };
+}
+
+static int clusterOf(const HpaGraph& g, int cell)
+{
+    return (cell / g.width / g.clusterSize) * g.clustersX + (cell % g.width) / g.clusterSize;
+}
+
+/**
+ * @brief Copy the costs of a cluster, indexed by Box::local
+ */
+static void loadCluster(const std::vector<int32_t>& costs, int width, const Box& box, std::vector<int32_t>& local)
+{
+    local.resize(static_cast<size_t>(box.w) * box.h);
+    for (int y = 0; y < box.h; ++y)
+    {
+        const auto row = costs.begin() + (box.y0 + y) * width + box.x0;
+        std::copy(row, row + box.w, local.begin() + y * box.w);
+    }
+}
+
+/**
+ * @brief Dijkstra inside a cluster, on its local costs and cell indices
+ *
+ * Forward distances are the costs of the cells entered from source on,
+ * reverse distances the costs of the cells entered on the way to source.
+ * With uniform costs the first visit is final and a FIFO replaces the heap.
+ * dist is -1 for unreached cells.
+ */
+static void clusterDistances(
+    const std::vector<int32_t>& local,
+    const Box& box,
+    int source,
+    bool reverse,
+    bool uniform,
+    std::vector<int32_t>& dist)
+{
+    const int cells = box.w * box.h;
+    dist.assign(cells, -1);
+    dist[source] = 0;
+
+    // Calls fn(neighbor, distance through cell) for the open neighbors in the cluster
+    auto forEachNeighbor = [&](int cell, int32_t d, auto&& fn)
+    {
+        const int x = cell % box.w;
+        const int neighbors[4] = {
+            x > 0 ? cell - 1 : -1,
+            x < box.w - 1 ? cell + 1 : -1,
+            cell - box.w,
+            cell + box.w < cells ? cell + box.w : -1
+        };
+        for (int n : neighbors)
+        {
+            if (n >= 0 && local[n] >= 0)
+                fn(n, d + (reverse ? local[cell] : local[n]));
+        }
+    };
+
+    if (uniform)
+    {
+        std::vector<int32_t> fifo(1, source);
+        for (size_t head = 0; head < fifo.size(); ++head)
+        {
+            const int cell = fifo[head];
+            forEachNeighbor(cell, dist[cell], [&](int n, int32_t newDist)
+            {
+                if (dist[n] < 0)
+                {
+                    dist[n] = newDist;
+                    fifo.push_back(n);
+                }
+            });
+        }
+        return;
+    }
+
+    using Entry = std::pair<int32_t, int32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    queue.push({ 0, source });
+
+    while (!queue.empty())
+    {
+        const auto [d, cell] = queue.top();
+        queue.pop();
+        if (d != dist[cell])
+            continue;
+
+        forEachNeighbor(cell, d, [&](int n, int32_t newDist)
+        {
+            if (dist[n] < 0 || newDist < dist[n])
+            {
+                dist[n] = newDist;
+                queue.push({ newDist, n });
+            }
+        });
+    }
+}
+
+/**
+ * @brief Append the shortest path inside a cluster from `from` (excluded) to `to`
+ * @return false if the walk finds no predecessor for a cell, path is unchanged then
+ */
+static bool appendClusterPath(
+    const std::vector<int32_t>& costs,
+    int width,
+    bool uniform,
+    const Box& box,
+    int from,
+    int to,
+    std::vector<int32_t>& path)
+{
+    std::vector<int32_t> local;
+    std::vector<int32_t> dist;
+    loadCluster(costs, width, box, local);
+    const int source = box.local(from, width);
+    clusterDistances(local, box, source, false, uniform, dist);
+
+    // Walk back like extractPath, but only through cells of the cluster
+    std::vector<int32_t> segment;
+    int cell = box.local(to, width);
+    while (cell != source)
+    {
+        segment.push_back((box.y0 + cell / box.w) * width + box.x0 + cell % box.w);
+        const int x = cell % box.w;
+        const int neighbors[4] = { x > 0 ? cell - 1 : -1, x < box.w - 1 ? cell + 1 : -1, cell - box.w, cell + box.w };
+        int prev = -1;
+        for (int n : neighbors)
+        {
+            if (n >= 0 && n < box.w * box.h && local[n] >= 0 && dist[n] >= 0 && dist[n] + local[cell] == dist[cell])
+            {
+                prev = n;
+                break;
+            }
+        }
+
+        if (prev < 0)
+        {
+            std::cerr << "No predecessor for cell " << segment.back() << " inside its cluster." << std::endl;
+            return false;
+        }
+        cell = prev;
+    }
+
+    path.insert(path.end(), segment.rbegin(), segment.rend());
+    return true;
+}
+
+bool buildHpaGraph(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    HpaGraph& graph
+)
+{
+    auto& g = graph;
+    const auto& costs = hostMazeCosts;
+
+    if (g.clusterSize < 2)
+    {
+        std::cerr << "HPA* cluster size must be at least 2." << std::endl;
+        return false;
+    }
+
+    if (!g.pool || (g.threadCount != 0 && g.pool->size() != g.threadCount))
+        g.pool = std::make_unique<Utils::ThreadPool>(g.threadCount);
+
+    g.width = mazeWidth;
+    g.height = mazeHeight;
+    g.clustersX = (mazeWidth + g.clusterSize - 1) / g.clusterSize;
+    g.clustersY = (mazeHeight + g.clusterSize - 1) / g.clusterSize;
+    const int clusterCount = g.clustersX * g.clustersY;
+
+    g.nodeCell.clear();
+    g.nodeOfCell.assign(static_cast<size_t>(mazeWidth) * mazeHeight, -1);
+    g.clusterNodes.assign(clusterCount, {});
+    g.edges.clear();
+
+    g.hWeight = std::numeric_limits<int32_t>::max();
+    int32_t maxCost = 0;
+    for (int32_t c : costs)
+    {
+        if (c >= 0)
+        {
+            g.hWeight = std::min(g.hWeight, c);
+            maxCost = std::max(maxCost, c);
+        }
+    }
+    if (g.hWeight == std::numeric_limits<int32_t>::max())
+        g.hWeight = 1;
+    g.uniform = g.hWeight == maxCost;
+
+    auto nodeFor = [&](int cell)
+    {
+        if (g.nodeOfCell[cell] < 0)
+        {
+            g.nodeOfCell[cell] = static_cast<int32_t>(g.nodeCell.size());
+            g.nodeCell.push_back(cell);
+            g.clusterNodes[clusterOf(g, cell)].push_back(g.nodeOfCell[cell]);
+            g.edges.emplace_back();
+        }
+        return g.nodeOfCell[cell];
+    };
+
+    auto addTransition = [&](int a, int b)
+    {
+        const int p = nodeFor(a);
+        const int q = nodeFor(b);
+        g.edges[p].push_back({ q, costs[b] });
+        g.edges[q].push_back({ p, costs[a] });
+    };
+
+    // Runs of open cell pairs along a border get a transition in the middle,
+    // long runs one at each end
+    auto scanBorder = [&](const std::function<int(int)>& cellA, const std::function<int(int)>& cellB, int length)
+    {
+        int runStart = -1;
+        for (int i = 0; i <= length; ++i)
+        {
+            const bool open = i < length && costs[cellA(i)] >= 0 && costs[cellB(i)] >= 0;
+            if (open && runStart < 0)
+                runStart = i;
+            if (open || runStart < 0)
+                continue;
+
+            const int runEnd = i - 1;
+            if (runEnd - runStart + 1 < 6)
+            {
+                const int mid = (runStart + runEnd) / 2;
+                addTransition(cellA(mid), cellB(mid));
+            }
+            else
+            {
+                addTransition(cellA(runStart), cellB(runStart));
+                addTransition(cellA(runEnd), cellB(runEnd));
+            }
+            runStart = -1;
+        }
+    };
+
+    for (int cluster = 0; cluster < clusterCount; ++cluster)
+    {
+        const Box box = clusterBox(g, cluster);
+        const int right = box.x0 + box.w;
+        const int bottom = box.y0 + box.h;
+
+        if (right < mazeWidth)
+        {
+            scanBorder(
+                [&](int i) { return (box.y0 + i) * mazeWidth + right - 1; },
+                [&](int i) { return (box.y0 + i) * mazeWidth + right; },
+                box.h);
+        }
+        if (bottom < mazeHeight)
+        {
+            scanBorder(
+                [&](int i) { return (bottom - 1) * mazeWidth + box.x0 + i; },
+                [&](int i) { return bottom * mazeWidth + box.x0 + i; },
+                box.w);
+        }
+    }
+
+    // Intra-cluster edges, every cluster only appends to the edges of its own nodes
+    g.pool->parallelFor(clusterCount, 16, [&](size_t begin, size_t end, unsigned)
+    {
+        std::vector<int32_t> local;
+        std::vector<int32_t> dist;
+        for (size_t cluster = begin; cluster < end; ++cluster)
+        {
+            const Box box = clusterBox(g, static_cast<int>(cluster));
+            const auto& nodes = g.clusterNodes[cluster];
+            if (nodes.size() < 2)
+                continue;
+
+            loadCluster(costs, mazeWidth, box, local);
+            for (int32_t n : nodes)
+            {
+                clusterDistances(local, box, box.local(g.nodeCell[n], mazeWidth), false, g.uniform, dist);
+                for (int32_t m : nodes)
+                {
+                    const int32_t d = dist[box.local(g.nodeCell[m], mazeWidth)];
+                    if (m != n && d >= 0)
+                        g.edges[n].push_back({ m, d });
+                }
+            }
+        }
+    });
+
+    size_t edgeCount = 0;
+    for (const auto& e : g.edges)
+        edgeCount += e.size();
+    std::cout << "HPA* graph with " << clusterCount << " clusters, " << g.nodeCell.size()
+              << " nodes and " << edgeCount << " edges" << std::endl;
+
+    return true;
+}
+
+std::vector<int32_t> findPathHpa(
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    const HpaGraph& graph
+)
+{
+    const auto& g = graph;
+    const auto& costs = hostMazeCosts;
+
+    std::vector<int32_t> path;
+    if (g.width != width || g.height != height)
+    {
+        std::cerr << "HPA* graph was built for a different maze." << std::endl;
+        return path;
+    }
+    if (costs[startIdx] < 0 || costs[targetIdx] < 0)
+        return path;
+
+    // Start and target join the graph as two extra nodes
+    const int32_t startNode = static_cast<int32_t>(g.nodeCell.size());
+    const int32_t targetNode = startNode + 1;
+    auto cellOf = [&](int32_t node)
+    {
+        return node == startNode ? startIdx : node == targetNode ? targetIdx : g.nodeCell[node];
+    };
+
+    const int startCluster = clusterOf(g, startIdx);
+    const int targetCluster = clusterOf(g, targetIdx);
+    const Box startBox = clusterBox(g, startCluster);
+    const Box targetBox = clusterBox(g, targetCluster);
+
+    std::vector<int32_t> local;
+    std::vector<int32_t> fromStart;
+    std::vector<int32_t> toTarget;
+    loadCluster(costs, width, startBox, local);
+    clusterDistances(local, startBox, startBox.local(startIdx, width), false, g.uniform, fromStart);
+    loadCluster(costs, width, targetBox, local);
+    clusterDistances(local, targetBox, targetBox.local(targetIdx, width), true, g.uniform, toTarget);
+
+    auto forEachEdge = [&](int32_t node, const std::function<void(int32_t, int32_t)>& fn)
+    {
+        if (node == startNode)
+        {
+            for (int32_t m : g.clusterNodes[startCluster])
+            {
+                const int32_t d = fromStart[startBox.local(g.nodeCell[m], width)];
+                if (d >= 0)
+                    fn(m, d);
+            }
+            if (startCluster == targetCluster && fromStart[startBox.local(targetIdx, width)] >= 0)
+                fn(targetNode, fromStart[startBox.local(targetIdx, width)]);
+            return;
+        }
+
+        for (const HpaEdge& e : g.edges[node])
+            fn(e.to, e.cost);
+        if (clusterOf(g, g.nodeCell[node]) == targetCluster)
+        {
+            const int32_t d = toTarget[targetBox.local(g.nodeCell[node], width)];
+            if (d >= 0)
+                fn(targetNode, d);
+        }
+    };
+
+    const int tx = targetIdx % width;
+    const int ty = targetIdx / width;
+    auto heuristic = [&](int32_t node)
+    {
+        const int cell = cellOf(node);
+        return g.hWeight * (std::abs(cell % width - tx) + std::abs(cell / width - ty));
+    };
+
+    // A* on the abstract graph, the labels only hold the nodes it reached
+    struct Label {
+        int32_t dist;
+        int32_t parent;
+    };
+    std::unordered_map<int32_t, Label> labels;
+    using Entry = std::tuple<int32_t, int32_t, int32_t>; // f, -dist, node
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> openList;
+
+    labels[startNode] = { 0, -1 };
+    openList.push({ heuristic(startNode), 0, startNode });
+
+    int expanded = 0;
+    bool found = false;
+    while (!openList.empty())
+    {
+        const auto [f, negDist, node] = openList.top();
+        openList.pop();
+        if (-negDist != labels[node].dist)
+            continue;
+        if (node == targetNode)
+        {
+            found = true;
+            break;
+        }
+        ++expanded;
+
+        forEachEdge(node, [&](int32_t to, int32_t cost)
+        {
+            const int32_t newDist = -negDist + cost;
+            auto it = labels.find(to);
+            if (it != labels.end() && newDist >= it->second.dist)
+                return;
+            labels[to] = { newDist, node };
+            openList.push({ newDist + heuristic(to), -newDist, to });
+        });
+    }
+
+    if (!found)
+    {
+        std::cout << "HPA* expanded " << expanded << " abstract nodes - path not found." << std::endl;
+        return path;
+    }
+
+    std::vector<int32_t> abstractPath;
+    for (int32_t node = targetNode; node >= 0; node = labels[node].parent)
+        abstractPath.push_back(node);
+    std::reverse(abstractPath.begin(), abstractPath.end());
+
+    // Refine: transitions are single steps, everything else stays inside one cluster
+    path.push_back(startIdx);
+    for (size_t i = 1; i < abstractPath.size(); ++i)
+    {
+        const int from = cellOf(abstractPath[i - 1]);
+        const int to = cellOf(abstractPath[i]);
+        if (from == to)
+            continue;
+
+        const int cluster = clusterOf(g, from);
+        if (cluster != clusterOf(g, to))
+            path.push_back(to);
+        else if (!appendClusterPath(costs, width, g.uniform, clusterBox(g, cluster), from, to, path))
+        {
+            std::cerr << "HPA* path refinement failed." << std::endl;
+            return {};
+        }
+    }
+
+    std::cout << "HPA* expanded " << expanded << " abstract nodes, path length "
+              << path.size() - 1 << std::endl;
+
+    return path;
+}
+
+} // namespace Maze
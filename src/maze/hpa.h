@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../utils/thread_pool.h"
+
+namespace Maze {
+
+struct HpaEdge {
+    int32_t to;
+    int32_t cost; /// sum of the costs of the cells entered on the way
+};
+
+/**
+ * @brief Abstract graph of hierarchical pathfinding (HPA*)
+ *
+ * The maze is cut into square clusters. Every run of open cells along a
+ * cluster border gets one or two transitions, and both cells of a transition
+ * become abstract nodes. Nodes of the same cluster are connected by their
+ * shortest distance inside the cluster, which is computed for all clusters
+ * in parallel. A query searches this graph and only refines the clusters on
+ * the abstract path, so its cost grows with the path length instead of the
+ * maze area. Paths are near optimal: they cross cluster borders only at
+ * transitions.
+ */
+struct HpaGraph {
+    int clusterSize = 32;     /// set before buildHpaGraph
+    unsigned threadCount = 0; /// 0 uses all cores
+
+    int width = 0;
+    int height = 0;
+    int clustersX = 0;
+    int clustersY = 0;
+    int32_t hWeight = 1; /// cheapest open cell, scales the heuristic
+    bool uniform = false; /// all open cells cost the same, clusters are searched with BFS
+
+    std::vector<int32_t> nodeCell;                 /// grid cell of every abstract node
+    std::vector<int32_t> nodeOfCell;               /// abstract node of every cell, -1 if none
+    std::vector<std::vector<int32_t>> clusterNodes; /// abstract nodes of every cluster
+    std::vector<std::vector<HpaEdge>> edges;       /// outgoing edges of every abstract node
+
+    std::unique_ptr<Utils::ThreadPool> pool;
+};
+
+/**
+ * @brief Build the abstract graph of a maze
+ * @param hostMazeCosts Cell costs, negative for walls
+ * @param mazeWidth Maze width
+ * @param mazeHeight Maze height
+ * @param graph Graph to fill, clusterSize and threadCount are read from it
+ * @return true on success
+ */
+bool buildHpaGraph(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    HpaGraph& graph
+);
+
+/**
+ * @brief Find a path on the abstract graph and refine it to grid cells
+ * @param hostMazeCosts Cell costs the graph was built from
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Start cell index
+ * @param targetIdx Target cell index
+ * @param graph Graph from buildHpaGraph
+ * @return Cell indices from start to target like extractPath, empty if there is no path
+ */
+std::vector<int32_t> findPathHpa(
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    const HpaGraph& graph
+);
+
+} // namespace Maze
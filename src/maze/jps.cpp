@@ -0,0 +1,267 @@
+#include "jps.h"
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <tuple>
+
+namespace Maze {
+
+static const int dirX[4] = { -1, 1, 0, 0 };
+static const int dirY[4] = { 0, 0, -1, 1 };
+
+namespace {
+
+/**
+ * @brief Wall lookup that treats everything outside the maze as a wall
+ */
+struct Grid {
+    const std::vector<int32_t>& costs;
+    int width;
+    int height;
+
+    bool open(int x, int y) const
+    {
+        return x >= 0 && x < width && y >= 0 && y < height && costs[y * width + x] >= 0;
+    }
+
+    /**
+     * @brief Whether a path moving in direction k can have to turn at (x, y):
+     * a side neighbor is open while the cell behind it is a wall
+     */
+    bool forced(int x, int y, int k) const
+    {
+        if (k < 2)
+        {
+            const int bx = x - dirX[k];
+            return (open(x, y - 1) && !open(bx, y - 1)) || (open(x, y + 1) && !open(bx, y + 1));
+        }
+        const int by = y - dirY[k];
+        return (open(x - 1, y) && !open(x - 1, by)) || (open(x + 1, y) && !open(x + 1, by));
+    }
+};
+
+} // namespace
+
+/**
+ * @brief Scan from (x, y) in direction k for the next jump point
+ * @return Cell index of the jump point or the target, -1 if a wall comes first
+ */
+static int jump(const Grid& grid, int x, int y, int k, int targetIdx)
+{
+    while (true)
+    {
+        x += dirX[k];
+        y += dirY[k];
+        if (!grid.open(x, y))
+            return -1;
+
+        const int idx = y * grid.width + x;
+        if (idx == targetIdx || grid.forced(x, y, k))
+            return idx;
+
+        // A vertical jump stops where a horizontal one would find something
+        if (k >= 2 && (jump(grid, x, y, 0, targetIdx) >= 0 || jump(grid, x, y, 1, targetIdx) >= 0))
+            return idx;
+    }
+}
+
+/**
+ * @brief Jump from cell c in direction k with the JPS+ table
+ * @return Cell index of the jump point or the target, -1 if a wall comes first
+ */
+static int jumpPlus(const JpsState& st, int width, int c, int k, int targetIdx)
+{
+    const int32_t j = st.jump[c][k];
+    const int span = j > 0 ? j : -j;
+    const int step = dirY[k] * width + dirX[k];
+
+    // The table does not know the target, stop on it or, for vertical jumps, on its row
+    const int x = c % width;
+    const int y = c / width;
+    const int along = (k < 2) ? (targetIdx % width - x) * dirX[k] : (targetIdx / width - y) * dirY[k];
+    const bool inLine = (k < 2) ? targetIdx / width == y : targetIdx % width == x;
+    if (along > 0 && along <= span && (inLine || k >= 2))
+        return c + along * step;
+
+    return j > 0 ? c + j * step : -1;
+}
+
+/**
+ * @brief Fill the JPS+ table, each direction is one sweep against it
+ */
+static void buildJumpTable(const Grid& grid, JpsState& st)
+{
+    const int width = grid.width;
+    const int height = grid.height;
+    st.jump.assign(static_cast<size_t>(width) * height, { 0, 0, 0, 0 });
+
+    // Entry of c from the entry of its neighbor n in direction k
+    auto fromNeighbor = [&](int c, int n, int k, bool jumpPoint)
+    {
+        if (jumpPoint)
+        {
+            st.jump[c][k] = 1;
+            return;
+        }
+        const int32_t next = st.jump[n][k];
+        st.jump[c][k] = next > 0 ? next + 1 : next - 1;
+    };
+
+    // Horizontal jumps first, vertical jump points depend on them
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = width - 2; x >= 0; --x)
+        {
+            if (grid.open(x, y) && grid.open(x + 1, y))
+                fromNeighbor(y * width + x, y * width + x + 1, 1, grid.forced(x + 1, y, 1));
+        }
+        for (int x = 1; x < width; ++x)
+        {
+            if (grid.open(x, y) && grid.open(x - 1, y))
+                fromNeighbor(y * width + x, y * width + x - 1, 0, grid.forced(x - 1, y, 0));
+        }
+    }
+
+    auto verticalJumpPoint = [&](int x, int y, int k)
+    {
+        const int n = y * width + x;
+        return grid.forced(x, y, k) || st.jump[n][0] > 0 || st.jump[n][1] > 0;
+    };
+
+    // Row by row, a row only depends on the one below (down) or above (up) it
+    for (int y = height - 2; y >= 0; --y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (grid.open(x, y) && grid.open(x, y + 1))
+                fromNeighbor(y * width + x, (y + 1) * width + x, 3, verticalJumpPoint(x, y + 1, 3));
+        }
+    }
+    for (int y = 1; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (grid.open(x, y) && grid.open(x, y - 1))
+                fromNeighbor(y * width + x, (y - 1) * width + x, 2, verticalJumpPoint(x, y - 1, 2));
+        }
+    }
+}
+
+bool initializeJpsState(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    JpsState& jpsState
+)
+{
+    auto& st = jpsState;
+
+    const size_t cells = static_cast<size_t>(mazeWidth) * mazeHeight;
+    st.dist.assign(cells, -1);
+    st.parent.assign(cells, -1);
+    st.dirIn.assign(cells, 4);
+    st.expanded = 0;
+
+    if (st.usePlus)
+        buildJumpTable(Grid{ hostMazeCosts, mazeWidth, mazeHeight }, st);
+    else
+        st.jump.clear();
+
+    return true;
+}
+
+std::vector<int32_t> findPathJps(
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    JpsState& jpsState
+)
+{
+    auto& st = jpsState;
+    const Grid grid{ hostMazeCosts, width, height };
+    const int tx = targetIdx % width;
+    const int ty = targetIdx / width;
+
+    std::fill(st.dist.begin(), st.dist.end(), -1);
+    std::fill(st.dirIn.begin(), st.dirIn.end(), 4);
+    st.expanded = 0;
+
+    std::vector<int32_t> path;
+    if (hostMazeCosts[startIdx] < 0 || hostMazeCosts[targetIdx] < 0)
+        return path;
+
+    auto heuristic = [&](int c) { return std::abs(c % width - tx) + std::abs(c / width - ty); };
+
+    // Open list of (f, -dist, cell), outdated entries are skipped when popped.
+    // On open maps whole regions share the same f, preferring the deepest
+    // entry among them heads straight for the target.
+    using Entry = std::tuple<int32_t, int32_t, int32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> openList;
+    st.dist[startIdx] = 0;
+    openList.push({ heuristic(startIdx), 0, startIdx });
+
+    bool found = false;
+    while (!openList.empty())
+    {
+        const auto [f, negDist, c] = openList.top();
+        openList.pop();
+        if (-negDist != st.dist[c])
+            continue;
+        if (c == targetIdx)
+        {
+            found = true;
+            break;
+        }
+        ++st.expanded;
+
+        for (int k = 0; k < 4; ++k)
+        {
+            // Straight on and both turns, going back never helps
+            if (st.dirIn[c] != 4 && k == (st.dirIn[c] ^ 1))
+                continue;
+
+            const int s = st.usePlus
+                ? jumpPlus(st, width, c, k, targetIdx)
+                : jump(grid, c % width, c / width, k, targetIdx);
+            if (s < 0)
+                continue;
+
+            // Jumps are straight, so their length is the Manhattan distance
+            const int32_t newDist = st.dist[c] + std::abs(s % width - c % width) + std::abs(s / width - c / width);
+            if (st.dist[s] >= 0 && newDist >= st.dist[s])
+                continue;
+
+            st.dist[s] = newDist;
+            st.parent[s] = c;
+            st.dirIn[s] = static_cast<uint8_t>(k);
+            openList.push({ newDist + heuristic(s), -newDist, s });
+        }
+    }
+
+    if (!found)
+    {
+        std::cout << "Jump point search expanded " << st.expanded << " jump points - path not found." << std::endl;
+        return path;
+    }
+
+    // Fill in the straight runs between consecutive jump points
+    for (int c = targetIdx; c != startIdx; c = st.parent[c])
+    {
+        const int step = dirY[st.dirIn[c]] * width + dirX[st.dirIn[c]];
+        for (int cell = c; cell != st.parent[c]; cell -= step)
+            path.push_back(cell);
+    }
+    path.push_back(startIdx);
+    std::reverse(path.begin(), path.end());
+
+    std::cout << "Jump point search expanded " << st.expanded << " jump points, path length "
+              << path.size() - 1 << std::endl;
+
+    return path;
+}
+
+} // namespace Maze
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Maze {
+
+/**
+ * @brief State of the jump point search for uniform costs
+ *
+ * A* over jump points on the 4-connected grid: a search only stops on cells
+ * where a path can turn, corridor interiors between two of them are skipped
+ * in one jump. With usePlus the jump distances are precomputed per cell and
+ * direction (JPS+), so a jump is a table lookup instead of a scan.
+ */
+struct JpsState {
+    /// Precompute the jump table in initializeJpsState, set before it
+    bool usePlus = false;
+
+    /// JPS+ jump table, one entry per cell and direction in the order of the
+    /// kernels (left, right, up, down). A positive entry is the number of steps
+    /// to the next jump point, otherwise minus the number of open cells in that direction.
+    std::vector<std::array<int32_t, 4>> jump;
+
+    std::vector<int32_t> dist;   /// distance of every reached jump point, -1 elsewhere
+    std::vector<int32_t> parent; /// previous jump point on the best known path
+    std::vector<uint8_t> dirIn;  /// direction a jump point was reached from, 4 for the start
+    int expanded = 0;            /// jump points taken from the open list by the last search
+};
+
+/**
+ * @brief Prepare the search, builds the JPS+ table if usePlus is set
+ * @param hostMazeCosts Cell costs, negative for walls, the values of open cells are ignored
+ * @param mazeWidth Maze width
+ * @param mazeHeight Maze height
+ * @param jpsState State to fill
+ * @return true on success
+ */
+bool initializeJpsState(
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    JpsState& jpsState
+);
+
+/**
+ * @brief Find a shortest path with jump point search
+ *
+ * Only the jump points are expanded, the cells between them are filled in
+ * when the path is assembled. The state can be reused for further queries
+ * on the same maze.
+ *
+ * @param hostMazeCosts Cell costs, negative for walls
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Start cell index
+ * @param targetIdx Target cell index
+ * @param jpsState State from initializeJpsState
+ * @return Cell indices from start to target like extractPath, empty if there is no path
+ */
+std::vector<int32_t> findPathJps(
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    JpsState& jpsState
+);
+
+} // namespace Maze
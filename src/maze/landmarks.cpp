@@ -0,0 +1,334 @@
+#include "landmarks.h"
+#include "batch.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+namespace Maze {
+
+static const uint16_t narrowUnreachable = std::numeric_limits<uint16_t>::max();
+static const uint32_t wideUnreachable = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Cost of entering a cell in the step model the fields were built with
+ */
+static int32_t stepCost(const LandmarkSet& landmarks, const std::vector<int32_t>& costs, int cell)
+{
+    return landmarks.weighted ? costs[cell] : 1;
+}
+
+/**
+ * @brief Drop the fields of a set, an empty set of cells marks it as not built
+ */
+static void clearLandmarks(LandmarkSet& landmarks)
+{
+    landmarks.cells.clear();
+    std::vector<uint16_t>().swap(landmarks.narrowFields);
+    std::vector<uint32_t>().swap(landmarks.wideFields);
+}
+
+/**
+ * @brief Open cell closest to (x, y) that is not a landmark yet, searched in growing rings
+ * @return Cell index, -1 if the maze has no such cell
+ */
+static int nearestOpenCell(
+    const std::vector<int32_t>& costs,
+    int width,
+    int height,
+    int x,
+    int y,
+    const std::vector<int32_t>& taken)
+{
+    for (int r = 0; r < std::max(width, height); ++r)
+    {
+        for (int dy = -r; dy <= r; ++dy)
+        {
+            // Only the outline of the ring, its inside was searched before
+            const int step = (dy == -r || dy == r) ? 1 : 2 * r;
+            for (int dx = -r; dx <= r; dx += step)
+            {
+                const int nx = x + dx;
+                const int ny = y + dy;
+                if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                    continue;
+
+                const int cell = ny * width + nx;
+                if (costs[cell] >= 0 && std::find(taken.begin(), taken.end(), cell) == taken.end())
+                    return cell;
+            }
+        }
+    }
+    return -1;
+}
+
+bool buildLandmarks(
+    Compute::CLContext& clContext,
+    const Compute::CLProgram& clProgram,
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    bool weighted,
+    int layout,
+    LandmarkSet& landmarks
+)
+{
+    auto& lm = landmarks;
+    clearLandmarks(lm);
+    lm.weighted = weighted;
+    lm.fieldCells = mazeWidth * mazeHeight;
+
+    // Landmarks behind the targets give the tightest bounds, so spread them
+    // evenly along the border where they are behind most of the maze
+    const int lastX = mazeWidth - 1;
+    const int lastY = mazeHeight - 1;
+    const int perimeter = 2 * (lastX + lastY);
+    for (int i = 0; i < lm.count; ++i)
+    {
+        // Clockwise from the top left corner, the sides end at these offsets
+        const int p = static_cast<int>(static_cast<int64_t>(i) * perimeter / std::max(lm.count, 1));
+        const int top = lastX;
+        const int right = lastX + lastY;
+        const int bottom = 2 * lastX + lastY;
+        const int x = p < top ? p : p < right ? lastX : p < bottom ? lastX - (p - right) : 0;
+        const int y = p < top ? 0 : p < right ? p - top : p < bottom ? lastY : lastY - (p - bottom);
+
+        const int cell = nearestOpenCell(hostMazeCosts, mazeWidth, mazeHeight, x, y, lm.cells);
+        if (cell >= 0)
+            lm.cells.push_back(cell);
+    }
+
+    if (lm.cells.empty())
+    {
+        std::cerr << "No open cell for a landmark." << std::endl;
+        return false;
+    }
+
+    std::vector<Query> queries;
+    for (int32_t cell : lm.cells)
+        queries.push_back({ cell, -1 });
+
+    BatchState batch;
+    batch.weighted = weighted;
+    batch.layout = layout;
+    if (!initializeBatchState(clContext, clProgram, hostMazeCosts, mazeWidth, mazeHeight, queries, batch))
+    {
+        clearLandmarks(lm);
+        return false;
+    }
+
+    // The bounds only hold for exact fields, runBatch rebuilds lists that overflowed
+    runBatch(clContext.getQueue(), batch, 1);
+
+    std::vector<int32_t> field;
+    int32_t maxDist = 0;
+    lm.wideFields.reserve(static_cast<size_t>(lm.cells.size()) * lm.fieldCells);
+    for (int k = 0; k < static_cast<int>(lm.cells.size()); ++k)
+    {
+        readBatchDistances(clContext.getQueue(), batch, k, field);
+        for (int32_t d : field)
+        {
+            maxDist = std::max(maxDist, d);
+            lm.wideFields.push_back(d < 0 ? wideUnreachable : static_cast<uint32_t>(d));
+        }
+    }
+
+    // The largest value is reserved for unreachable cells
+    lm.narrow = maxDist < narrowUnreachable;
+    if (lm.narrow)
+    {
+        lm.narrowFields.resize(lm.wideFields.size());
+        std::transform(lm.wideFields.begin(), lm.wideFields.end(), lm.narrowFields.begin(),
+            [](uint32_t d) { return d == wideUnreachable ? narrowUnreachable : static_cast<uint16_t>(d); });
+        std::vector<uint32_t>().swap(lm.wideFields);
+    }
+
+    std::cout << "Built " << lm.cells.size() << " landmark fields with "
+              << (lm.narrow ? 16 : 32) << " bits per distance" << std::endl;
+
+    return true;
+}
+
+int32_t landmarkDistance(const LandmarkSet& landmarks, int k, int cell)
+{
+    const size_t i = static_cast<size_t>(k) * landmarks.fieldCells + cell;
+    if (landmarks.narrow)
+    {
+        const uint16_t d = landmarks.narrowFields[i];
+        return d == narrowUnreachable ? -1 : d;
+    }
+    const uint32_t d = landmarks.wideFields[i];
+    return d == wideUnreachable ? -1 : static_cast<int32_t>(d);
+}
+
+int32_t landmarkLowerBound(
+    const LandmarkSet& landmarks,
+    const std::vector<int32_t>& hostMazeCosts,
+    int cell,
+    int targetIdx
+)
+{
+    int32_t bound = 0;
+    for (int k = 0; k < static_cast<int>(landmarks.cells.size()); ++k)
+    {
+        const int32_t fromL = landmarkDistance(landmarks, k, cell);
+        const int32_t targetFromL = landmarkDistance(landmarks, k, targetIdx);
+        if (fromL < 0 || targetFromL < 0)
+            continue;
+
+        // d(L, t) - d(L, x) and d(x, L) - d(t, L), the cost of L cancels out
+        bound = std::max(bound, targetFromL - fromL);
+        bound = std::max(bound, (fromL - stepCost(landmarks, hostMazeCosts, cell))
+            - (targetFromL - stepCost(landmarks, hostMazeCosts, targetIdx)));
+    }
+    return bound;
+}
+
+/**
+ * @brief Follow the field of landmark k from a cell down to the landmark
+ * @return Cells from `from` to the landmark, a shortest path in both directions,
+ *         empty if the field has no predecessor for a cell
+ */
+static std::vector<int32_t> walkToLandmark(
+    const LandmarkSet& landmarks,
+    const std::vector<int32_t>& costs,
+    int width,
+    int height,
+    int k,
+    int from)
+{
+    const int cells = width * height;
+    const int offsets[] = { -1, 1, -width, width };
+    std::vector<int32_t> path(1, from);
+
+    int cell = from;
+    while (cell != landmarks.cells[k])
+    {
+        const int x = cell % width;
+        const int32_t d = landmarkDistance(landmarks, k, cell);
+        int prev = -1;
+        for (int i = 0; i < 4 && prev < 0; ++i)
+        {
+            const int n = cell + offsets[i];
+            if ((i == 0 && x == 0) || (i == 1 && x == width - 1) || n < 0 || n >= cells)
+                continue;
+
+            const int32_t dn = landmarkDistance(landmarks, k, n);
+            if (costs[n] >= 0 && dn >= 0 && dn + stepCost(landmarks, costs, cell) == d)
+                prev = n;
+        }
+
+        if (prev < 0)
+        {
+            std::cerr << "No predecessor for cell " << cell << " in landmark field " << k << "." << std::endl;
+            return {};
+        }
+        cell = prev;
+        path.push_back(cell);
+    }
+
+    return path;
+}
+
+std::vector<int32_t> findPathAlt(
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    const LandmarkSet& landmarks
+)
+{
+    const auto& costs = hostMazeCosts;
+    std::vector<int32_t> path;
+    if (costs[startIdx] < 0 || costs[targetIdx] < 0)
+        return path;
+
+    // Queries from or to a landmark need no search
+    for (int k = 0; k < static_cast<int>(landmarks.cells.size()); ++k)
+    {
+        const bool fromLandmark = landmarks.cells[k] == startIdx;
+        if (!fromLandmark && landmarks.cells[k] != targetIdx)
+            continue;
+
+        const int other = fromLandmark ? targetIdx : startIdx;
+        if (landmarkDistance(landmarks, k, other) < 0)
+            return path;
+
+        path = walkToLandmark(landmarks, costs, width, height, k, other);
+        if (path.empty())
+            return path;
+        if (fromLandmark)
+            std::reverse(path.begin(), path.end());
+
+        std::cout << "Answered from landmark field " << k << ", path length " << path.size() - 1 << std::endl;
+        return path;
+    }
+
+    // A* with labels for the reached cells only, a query does not touch the whole maze
+    struct Label {
+        int32_t dist;
+        int32_t parent;
+    };
+    std::unordered_map<int32_t, Label> labels;
+    using Entry = std::tuple<int32_t, int32_t, int32_t>; // f, -dist, cell
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> openList;
+
+    labels[startIdx] = { 0, -1 };
+    openList.push({ landmarkLowerBound(landmarks, costs, startIdx, targetIdx), 0, startIdx });
+
+    int expanded = 0;
+    bool found = false;
+    while (!openList.empty())
+    {
+        const auto [f, negDist, cell] = openList.top();
+        openList.pop();
+        if (-negDist != labels[cell].dist)
+            continue;
+        if (cell == targetIdx)
+        {
+            found = true;
+            break;
+        }
+        ++expanded;
+
+        const int x = cell % width;
+        const int y = cell / width;
+        for (int k = 0; k < 4; ++k)
+        {
+            const int nx = x + ((k == 0) ? -1 : (k == 1) ? 1 : 0);
+            const int ny = y + ((k == 2) ? -1 : (k == 3) ? 1 : 0);
+            if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+                continue;
+
+            const int n = ny * width + nx;
+            if (costs[n] < 0)
+                continue;
+
+            const int32_t newDist = -negDist + stepCost(landmarks, costs, n);
+            auto it = labels.find(n);
+            if (it != labels.end() && newDist >= it->second.dist)
+                continue;
+
+            labels[n] = { newDist, cell };
+            openList.push({ newDist + landmarkLowerBound(landmarks, costs, n, targetIdx), -newDist, n });
+        }
+    }
+
+    if (!found)
+    {
+        std::cout << "ALT search expanded " << expanded << " cells - path not found." << std::endl;
+        return path;
+    }
+
+    for (int32_t cell = targetIdx; cell >= 0; cell = labels[cell].parent)
+        path.push_back(cell);
+    std::reverse(path.begin(), path.end());
+
+    std::cout << "ALT search expanded " << expanded << " cells, path length " << path.size() - 1 << std::endl;
+    return path;
+}
+
+} // namespace Maze
@@ -0,0 +1,99 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "../compute/cl_context.h"
+#include "../compute/cl_program.h"
+
+namespace Maze {
+
+/**
+ * @brief Distance fields of a few landmark cells, kept for the lifetime of a maze
+ *
+ * For any cell x and target t the triangle inequality gives the lower bounds
+ * d(x, t) >= d(L, t) - d(L, x) and d(x, t) >= d(x, L) - d(t, L), the ALT
+ * heuristic. Entering a cell costs its own cost, so the distance back to a
+ * landmark follows from the same field: d(x, L) = d(L, x) - cost(x) + cost(L).
+ *
+ * Fields are stored as 16 bit values when every distance fits, otherwise as
+ * 32 bit values, with the maximum value marking unreachable cells. The
+ * uniform kernel counts every step as 1, so queries use the step cost of the
+ * kernel that built the fields.
+ */
+struct LandmarkSet {
+    int count = 8; /// number of landmarks, set before buildLandmarks
+
+    std::vector<int32_t> cells; /// landmark cell indices, empty unless the fields are built
+    bool weighted = false;      /// fields were built by the weighted kernel, unit steps otherwise
+    int fieldCells = 0;         /// cells per field
+    bool narrow = false;        /// fields are in narrowFields instead of wideFields
+    std::vector<uint16_t> narrowFields;
+    std::vector<uint32_t> wideFields;
+};
+
+/**
+ * @brief Pick landmarks along the maze border and compute their fields in one batch
+ * @param clContext OpenCL context, its queue runs the batch
+ * @param clProgram Uniform or weighted program, both provide expand_wave_batch
+ * @param hostMazeCosts Cell costs, negative for walls
+ * @param mazeWidth Maze width
+ * @param mazeHeight Maze height
+ * @param weighted Whether clProgram is the weighted program
+ * @param layout Cell layout clProgram was built with
+ * @param landmarks Set to fill, count is read from it
+ * @return false if the batch can not be run, the set is left empty then
+ */
+bool buildLandmarks(
+    Compute::CLContext& clContext,
+    const Compute::CLProgram& clProgram,
+    const std::vector<int32_t>& hostMazeCosts,
+    int mazeWidth,
+    int mazeHeight,
+    bool weighted,
+    int layout,
+    LandmarkSet& landmarks
+);
+
+/**
+ * @brief Distance from landmark k to a cell, -1 if unreachable
+ */
+int32_t landmarkDistance(const LandmarkSet& landmarks, int k, int cell);
+
+/**
+ * @brief Largest ALT lower bound of the distance from a cell to the target
+ */
+int32_t landmarkLowerBound(
+    const LandmarkSet& landmarks,
+    const std::vector<int32_t>& hostMazeCosts,
+    int cell,
+    int targetIdx
+);
+
+/**
+ * @brief A* on the grid with the ALT heuristic
+ *
+ * Queries that start or end at a landmark are read straight off its field.
+ * Steps cost like in the kernel that built the fields (LandmarkSet::weighted).
+ *
+ * @param hostMazeCosts Cell costs the landmarks were built from
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Start cell index
+ * @param targetIdx Target cell index
+ * @param landmarks Set from buildLandmarks
+ * @return Cell indices from start to target like extractPath, empty if there is no path
+ */
+std::vector<int32_t> findPathAlt(
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    const LandmarkSet& landmarks
+);
+
+} // namespace Maze
@@ -3,11 +3,14 @@
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
 
 namespace Maze {
 
 std::vector<int32_t> createMaze(
-    unsigned int size, const std::string& algorithm, bool randomCost)
+    unsigned int width, unsigned int height, const std::string& algorithm, bool randomCost)
 {
     if (algorithm == "test") {
         return {
@@ -20,7 +23,7 @@ std::vector<int32_t> createMaze(
     }
 
     char cmd[256];
-    std::snprintf(cmd, sizeof(cmd), "python gen_maze.py %u \"%s\"", size, algorithm.c_str());
+    std::snprintf(cmd, sizeof(cmd), "python gen_maze.py %u %u \"%s\"", width, height, algorithm.c_str());
     int ret = std::system(cmd);
     if (ret != 0)
     {
@@ -28,7 +31,7 @@ std::vector<int32_t> createMaze(
         return {};
     }
 
-    std::vector<uint8_t> mazeBytes(size * size);
+    std::vector<uint8_t> mazeBytes(static_cast<size_t>(width) * height);
 
     std::ifstream file("maze.bin", std::ios::binary);
     if (!file.is_open())
@@ -66,57 +69,148 @@ std::vector<int32_t> createMaze(
     return mazeData;
 }
 
+uint16_t encodeCell(const std::vector<int32_t>& costs, int width, int height, int x, int y)
+{
+    auto open = [&](int cx, int cy)
+    {
+        return cx >= 0 && cx < width && cy >= 0 && cy < height && costs[static_cast<size_t>(cy) * width + cx] >= 0;
+    };
+
+    const int32_t cost = costs[static_cast<size_t>(y) * width + x];
+    if (cost < 0)
+        return 0;
+
+    uint16_t cell = cellOpen | static_cast<uint16_t>(std::min(cost, 255) << 8);
+    if (open(x - 1, y)) cell |= 1;
+    if (open(x + 1, y)) cell |= 2;
+    if (open(x, y - 1)) cell |= 4;
+    if (open(x, y + 1)) cell |= 8;
+    return cell;
+}
+
+std::vector<uint16_t> encodeCells(const std::vector<int32_t>& costs, int width, int height)
+{
+    std::vector<uint16_t> cells(costs.size(), 0);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            cells[static_cast<size_t>(y) * width + x] = encodeCell(costs, width, height, x, y);
+    }
+    return cells;
+}
+
+cl::Buffer createCellBuffer(
+    const cl::Context& context,
+    const std::vector<int32_t>& costs,
+    int width,
+    int height,
+    bool weighted,
+    int layout)
+{
+    std::vector<uint16_t> cells = toDeviceLayout(encodeCells(costs, width, height), width, height, layout, uint16_t(0));
+    if (weighted)
+    {
+        return cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+            sizeof(uint16_t) * cells.size(), cells.data());
+    }
+
+    std::vector<uint8_t> moves(cells.begin(), cells.end()); // keeps the low bytes
+    return cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+        sizeof(uint8_t) * moves.size(), moves.data());
+}
+
+std::string kernelOptions(int layout, int width, int height)
+{
+    std::string options = "-DCELL_LAYOUT=" + std::to_string(layout);
+    if (width > 0 && height > 0)
+        options += " -DMAZE_W=" + std::to_string(width) + " -DMAZE_H=" + std::to_string(height);
+    return options;
+}
+
 bool initializeMazeState(
     const Compute::CLContext& clContext,
     const Compute::CLProgram& clProgram,
     const std::vector<int32_t>& hostMazeCosts,
-    int mazeSize, int startIndex,
+    int width, int height, int startIndex, int targetIndex,
     MazeState& mazeState
 )
 {
     auto& st = mazeState;
     // Initialize buffers
     // Wall buffer is already generated in initMaze
-    
-    const int maxWfSize = 2 * (std::max(mazeSize, mazeSize) - 1);
-    const int indexArrSize = 4 * maxWfSize;
 
-    st.prevHost.resize(indexArrSize, -1);
-    st.nextHost.resize(indexArrSize, -1);
-    st.distHost.resize(mazeSize * mazeSize, -1);
-    st.visitedFlag.resize(mazeSize * mazeSize, 0);
-    st.foundFlagHost.resize(1, 0);
+    st.deviceCells = layout_cells(st.layout, width, height);
+    const int startCell = deviceIndex(st.layout, width, startIndex);
+    const int targetCell = deviceIndex(st.layout, width, targetIndex);
+
+    // Enough for the corridors of perfect mazes, open and weighted grids grow the lists
+    const int maxWfSize = 2 * (std::max(width, height) - 1);
+    st.wfCapacity = std::min(4 * maxWfSize, st.deviceCells);
+    st.wfGrowths = 0;
+    if (st.tiled)
+    {
+        // Every tile is at most once in a list
+        st.tilesX = (width + MazeState::tileSize - 1) / MazeState::tileSize;
+        st.tilesY = (height + MazeState::tileSize - 1) / MazeState::tileSize;
+        st.wfCapacity = st.tilesX * st.tilesY;
+    }
+
+    st.distHost.assign(static_cast<size_t>(width) * height, -1);
+    st.visitedFlag.assign(st.deviceCells, 0);
+    st.foundFlagHost.assign(1, 0);
 
     st.distHost[startIndex] = 0;
-    st.prevHost[0] = startIndex;
+
+    st.openCells = static_cast<int>(std::count_if(
+        hostMazeCosts.begin(), hostMazeCosts.end(), [](int32_t c) { return c >= 0; }));
+    st.bottomUp = false;
+    st.level = 0;
+    st.targetDist = -1;
+
+    // The first wavefront only holds the start cell, or its tile
+    const int startTile = (startIndex / width / MazeState::tileSize) * st.tilesX
+        + startIndex % width / MazeState::tileSize;
+    std::vector<int32_t> prevHost(st.wfCapacity, -1);
+    prevHost[0] = st.tiled ? startTile : startCell;
+    int32_t prevSize = 1;
+    int32_t nextSize = 0;
 
     // Create OpenCL buffers
-    st.costBuf = cl::Buffer(
-        clContext.getContext(),
-        CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-        sizeof(int32_t) * hostMazeCosts.size(),
-        const_cast<int32_t*> (hostMazeCosts.data()) /// cast away const...
-    );
+    st.cellBuf = createCellBuffer(clContext.getContext(), hostMazeCosts, width, height, st.weighted, st.layout);
 
     st.prevBuf = cl::Buffer(
         clContext.getContext(),
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        sizeof(int32_t) * st.prevHost.size(),
-        st.prevHost.data()
+        sizeof(int32_t) * prevHost.size(),
+        prevHost.data()
     );
 
     st.nextBuf = cl::Buffer(
+        clContext.getContext(),
+        CL_MEM_READ_WRITE,
+        sizeof(int32_t) * st.wfCapacity
+    );
+
+    st.prevSizeBuf = cl::Buffer(
         clContext.getContext(),
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        sizeof(int32_t) * st.nextHost.size(),
-        st.nextHost.data()
+        sizeof(int32_t),
+        &prevSize
     );
 
+    st.nextSizeBuf = cl::Buffer(
+        clContext.getContext(),
+        CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+        sizeof(int32_t),
+        &nextSize
+    );
+
+    std::vector<int32_t> distDevice = toDeviceLayout(st.distHost, width, height, st.layout, -1);
     st.distBuf = cl::Buffer(
         clContext.getContext(),
         CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
-        sizeof(int32_t) * st.distHost.size(),
-        st.distHost.data()
+        sizeof(int32_t) * distDevice.size(),
+        distDevice.data()
     );
 
     st.foundFlagBuf = cl::Buffer(
@@ -126,8 +220,172 @@ bool initializeMazeState(
         st.foundFlagHost.data()
     );
 
-    // Create kernel
+    // Only written when a list overflows, the host resets it before every rebuild
+    st.levelBuf = cl::Buffer(clContext.getContext(), CL_MEM_READ_WRITE, sizeof(int32_t));
+    st.repairBuf = cl::Buffer(); // sized for the previous maze
+
+    st.distView.assign((st.deviceCells + 1) / 2 * 2, 0xFFFF);
+    st.distView[startCell] = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        // A readback of the previous run may still write into the staging vector
+        if (st.distViewEvents[i]())
+            st.distViewEvents[i].wait();
+        st.distViewEvents[i] = cl::Event();
+        st.distViewStaging[i].assign(st.distView.size(), 0xFFFF);
+        st.distViewBufs[i] = cl::Buffer(clContext.getContext(), CL_MEM_READ_WRITE, sizeof(uint16_t) * st.deviceCells);
+    }
+    st.distViewSlot = 0;
+
+    if (st.aStar)
+    {
+        // The uniform kernel takes unit steps whatever the costs are
+        st.hWeight = 1;
+        if (st.weighted)
+        {
+            st.hWeight = std::numeric_limits<int32_t>::max();
+            for (int32_t c : hostMazeCosts)
+            {
+                if (c >= 0)
+                    st.hWeight = std::min(st.hWeight, c);
+            }
+        }
+    }
+
+    if (st.deltaStepping || st.aStar)
+    {
+        // Every cell is at most once in the far pile
+        st.farCapacity = static_cast<int>(hostMazeCosts.size());
+        st.threshold = st.delta;
+        if (st.aStar)
+        {
+            // Start with the band holding the f of the start cell
+            const int dx = std::abs(startIndex % width - targetIndex % width);
+            const int dy = std::abs(startIndex / width - targetIndex / width);
+            st.threshold = (st.hWeight * (dx + dy) / st.fBand + 1) * st.fBand;
+        }
+        st.farSize = 0;
+        st.farMin = std::numeric_limits<int32_t>::max();
+
+        st.farBuf = cl::Buffer(clContext.getContext(), CL_MEM_READ_WRITE, sizeof(int32_t) * st.farCapacity);
+        st.farNextBuf = cl::Buffer(clContext.getContext(), CL_MEM_READ_WRITE, sizeof(int32_t) * st.farCapacity);
+
+        st.farSizeBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t),
+            &st.farSize
+        );
+
+        st.farNextSizeBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t),
+            &st.farSize
+        );
+
+        std::vector<int32_t> farFlags(st.deviceCells, 0);
+        st.farFlagBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t) * farFlags.size(),
+            farFlags.data()
+        );
+
+        st.farMinBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t),
+            &st.farMin
+        );
+    }
+
+    if (st.bidirectional)
+    {
+        // The reverse wavefront starts at the target
+        std::vector<int32_t> revPrevHost(st.wfCapacity, -1);
+        revPrevHost[0] = targetCell;
+        st.distRevHost.assign(static_cast<size_t>(width) * height, -1);
+        st.distRevHost[targetIndex] = 0;
+        std::vector<int32_t> distRevDevice = toDeviceLayout(st.distRevHost, width, height, st.layout, -1);
+        std::vector<int32_t> meetHost = { std::numeric_limits<int32_t>::max(), -1, -1, -1 };
+
+        st.revPrevBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t) * revPrevHost.size(),
+            revPrevHost.data()
+        );
+
+        st.revNextBuf = cl::Buffer(clContext.getContext(), CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+
+        st.revPrevSizeBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t),
+            &prevSize
+        );
+
+        st.revNextSizeBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t),
+            &nextSize
+        );
+
+        st.distRevBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t) * distRevDevice.size(),
+            distRevDevice.data()
+        );
+
+        st.meetBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t) * meetHost.size(),
+            meetHost.data()
+        );
+    }
+
+    if (st.tiled)
+    {
+        std::vector<int32_t> tileFlags(st.wfCapacity, 0);
+        tileFlags[startTile] = 1;
+        st.tileFlagBuf = cl::Buffer(
+            clContext.getContext(),
+            CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+            sizeof(int32_t) * tileFlags.size(),
+            tileFlags.data()
+        );
+    }
+
+    // Create kernels
     st.kernel = cl::Kernel(clProgram.getProgram(), "expand_wave_idxs");
+    st.narrowKernel = cl::Kernel(clProgram.getProgram(), "narrow_distances");
+    st.rebuildKernel = cl::Kernel(clProgram.getProgram(), "rebuild_frontier");
+    st.invalidateKernel = cl::Kernel(clProgram.getProgram(), "invalidate_distances");
+    st.seedRepairKernel = cl::Kernel(clProgram.getProgram(), "seed_repair");
+    st.clearKernel = cl::Kernel(clProgram.getProgram(), "clear_distances_from");
+    // Weighted expansions already correct distances that were written before
+    st.relaxKernel = cl::Kernel(clProgram.getProgram(), st.weighted ? "expand_wave_idxs" : "relax_wave_idxs");
+    if (st.directionOptimizing)
+    {
+        st.bottomUpKernel = cl::Kernel(clProgram.getProgram(), "expand_wave_bottom_up");
+    }
+    if (st.bidirectional)
+    {
+        st.bidirKernel = cl::Kernel(clProgram.getProgram(), "expand_wave_bidir");
+    }
+    if (st.deltaStepping || st.aStar)
+    {
+        st.nearFarKernel = cl::Kernel(clProgram.getProgram(), st.aStar ? "expand_wave_astar" : "expand_wave_near_far");
+        st.splitFarKernel = cl::Kernel(clProgram.getProgram(), "split_far_pile");
+    }
+    if (st.tiled)
+    {
+        st.tileKernel = cl::Kernel(clProgram.getProgram(), "expand_tiles");
+    }
 
     return true;
 }
@@ -9,39 +9,267 @@
 
 #include "../compute/cl_context.h"
 #include "../compute/cl_program.h"
-
+#include "shared/cell_layout.h"
 
 namespace Maze {
 
 /**
  * @brief Create a maze using Python script
- * @param size Size of the maze (width and height)
- * @param algorithm Algorithm to use ("kruskal" or "depthfs")
- * @return Vector of cost data (negative = wall, positive = cost this is between 1 and 255)
+ * @param width Number of columns
+ * @param height Number of rows
+ * @param algorithm Algorithm to use ("kruskal", "depthfs" or "open")
+ * @return Row-major vector of cost data (negative = wall, positive = cost this is between 1 and 255)
+ */
+std::vector<int32_t> createMaze(
+    unsigned int width, unsigned int height, const std::string& algorithm, bool randomCost = false);
+
+/// Flag of open cells in the encoding of encodeCells
+constexpr uint16_t cellOpen = 0x10;
+
+/**
+ * @brief Compact cell encoding of the kernels and the renderer
+ *
+ * Bit k of the low byte is set if the move in direction k (left, right, up,
+ * down) stays inside the maze and enters an open cell, cellOpen marks the
+ * open cells themselves. The high byte holds the cost of entering the cell.
+ * The uniform program and the renderer only take the low byte.
+ *
+ * @param costs Row-major cell costs, negative for walls, costs above 255 are clamped
+ * @param width Maze width
+ * @param height Maze height
+ * @return One word per cell
+ */
+std::vector<uint16_t> encodeCells(const std::vector<int32_t>& costs, int width, int height);
+
+/**
+ * @brief Encoding of a single cell, see encodeCells
+ * @param costs Row-major cell costs, negative for walls
+ * @param width Maze width
+ * @param height Maze height
+ * @param x Column of the cell
+ * @param y Row of the cell
+ * @return 0 for walls
+ */
+uint16_t encodeCell(const std::vector<int32_t>& costs, int width, int height, int x, int y);
+
+/**
+ * @brief Storage index of a row-major cell index in a layout of cell_layout.h
+ */
+inline int deviceIndex(int layout, int width, int idx)
+{
+    return layout_index(layout, width, idx % width, idx / width);
+}
+
+/**
+ * @brief Row-major cell index of a storage index in a layout of cell_layout.h
+ */
+inline int rowMajorIndex(int layout, int width, int deviceIdx)
+{
+    return layout_y(layout, width, deviceIdx) * width + layout_x(layout, width, deviceIdx);
+}
+
+/**
+ * @brief Reorder a row-major grid into a device layout
+ * @param grid Row-major grid of width * height values
+ * @param width Maze width
+ * @param height Maze height
+ * @param layout Layout of cell_layout.h
+ * @param padding Value of the cells a blocked layout adds past the maze border
+ * @return layout_cells values
+ */
+template <typename T>
+std::vector<T> toDeviceLayout(const std::vector<T>& grid, int width, int height, int layout, T padding)
+{
+    if (layout == LAYOUT_ROW_MAJOR)
+        return grid;
+
+    std::vector<T> device(static_cast<size_t>(layout_cells(layout, width, height)), padding);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            device[layout_index(layout, width, x, y)] = grid[static_cast<size_t>(y) * width + x];
+    }
+    return device;
+}
+
+/**
+ * @brief Reorder a grid in a device layout back to row-major, the padding is dropped
+ */
+template <typename T>
+void fromDeviceLayout(const std::vector<T>& device, int width, int height, int layout, std::vector<T>& grid)
+{
+    grid.resize(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            grid[static_cast<size_t>(y) * width + x] = device[layout_index(layout, width, x, y)];
+    }
+}
+
+/**
+ * @brief Upload encoded cells in a device layout, two bytes per cell for the
+ * weighted program and one byte otherwise. Padding cells are walls.
+ */
+cl::Buffer createCellBuffer(
+    const cl::Context& context,
+    const std::vector<int32_t>& costs,
+    int width,
+    int height,
+    bool weighted,
+    int layout = LAYOUT_ROW_MAJOR);
+
+/**
+ * @brief Build options of a program variant
+ *
+ * The layout is always compiled in. A variant specialized for one maze also
+ * fixes its size, its kernels ignore their width and height arguments (see
+ * FIX_DIMS) and can only run on grids of exactly that size.
+ *
+ * @param layout Cell layout of cell_layout.h
+ * @param width Maze width to compile in, 0 keeps the size a kernel argument
+ * @param height Maze height to compile in
+ * @return Options for Compute::CLProgram
  */
-std::vector<int32_t> createMaze(unsigned int size, const std::string& algorithm, bool randomCost = false);
+std::string kernelOptions(int layout, int width = 0, int height = 0);
 
 struct MazeState {
-    cl::Buffer costBuf;
+    cl::Buffer cellBuf;     /// encoded cells, see encodeCells
     cl::Buffer prevBuf;
     cl::Buffer nextBuf;
+    cl::Buffer prevSizeBuf; /// device side wavefront counters, swapped with prev/next
+    cl::Buffer nextSizeBuf;
     cl::Buffer distBuf;
     cl::Buffer foundFlagBuf;
 
-    std::vector<int32_t> prevHost;
-    std::vector<int32_t> nextHost;
+    cl::Buffer farBuf;     /// far pile, only created for delta-stepping and A*
+    cl::Buffer farNextBuf;
+    cl::Buffer farSizeBuf;
+    cl::Buffer farNextSizeBuf;
+    cl::Buffer farFlagBuf; /// one int per cell, set while the cell is in the far pile
+    cl::Buffer farMinBuf;  /// smallest distance in the far pile
+
+    cl::Buffer revPrevBuf; /// reverse wavefront, only created for bidirectional BFS
+    cl::Buffer revNextBuf;
+    cl::Buffer revPrevSizeBuf;
+    cl::Buffer revNextSizeBuf;
+    cl::Buffer distRevBuf; /// distances to the target
+    cl::Buffer meetBuf;    /// meeting level and candidate edges, see expand_wave_bidir
+
+    /// 16 bit distances for the renderer, double-buffered so one view can be
+    /// read back while the next is written, see readDistanceView
+    cl::Buffer distViewBufs[2];
+    cl::Event distViewEvents[2]; /// readbacks of the two view buffers, invalid until the first one
+    int distViewSlot = 0;        /// view buffer written by the next readDistanceView
+
+    cl::Buffer tileFlagBuf; /// one int per tile, set while the tile is queued, only created for tiled runs
+    cl::Buffer levelBuf;    /// largest distance in a rebuilt frontier, see rebuild_frontier
+
+    cl::Buffer repairBuf;     /// invalidated cells of a repair, created by the first repairDistances
+    cl::Buffer repairSizeBuf;
+
+    /// Number of index slots in prevBuf and nextBuf. Starts at a bound for thin
+    /// maze corridors and grows when a sync point finds that a list overflowed,
+    /// see rebuild_frontier.
+    int wfCapacity = 0;
+    int wfGrowths = 0;  /// number of times the lists were grown in this run
+    int openCells = 0;  /// number of non-wall cells
+
+    /// Cell layout of the device grids (cells, distances, flags and the renderer
+    /// buffers), LAYOUT_ROW_MAJOR or LAYOUT_BLOCKED of cell_layout.h. Has to match
+    /// the CELL_LAYOUT the program was built with, set before initializeMazeState.
+    /// Wavefronts hold storage indices, the host side distances stay row-major.
+    int layout = LAYOUT_ROW_MAJOR;
+    int deviceCells = 0; /// cells of the device grids, blocked layouts pad to whole blocks
+
+    /// Direction-optimizing BFS, only for the uniform kernel, set before initializeMazeState.
+    /// A step runs bottom-up once the wavefront holds more than 1/buAlpha of the
+    /// open cells and goes back to top-down below 1/buBeta of them.
+    bool directionOptimizing = false;
+    int buAlpha = 16;
+    int buBeta = 64;
+
+    bool bottomUp = false; /// direction of the next step
+    int level = 0;         /// step count, equal to the distance of the current wavefront for uniform costs
+
+    /// Delta-stepping with near-far piles, only for the weighted kernel, set before
+    /// initializeMazeState. Cells reached with a distance of at least `threshold`
+    /// wait in the far pile, the threshold advances in multiples of delta.
+    bool deltaStepping = false;
+    int delta = 128;
+
+    int threshold = 0;
+    int32_t farSize = 0; /// host copies, read at sync points
+    int32_t farMin = 0;
+    int farCapacity = 0;
+
+    /// A*, for both kernels, set before initializeMazeState. Runs on the near-far
+    /// piles of delta-stepping, but the buckets are fBand wide and hold cells by
+    /// f = dist + the Manhattan distance to the target times hWeight, the cheapest
+    /// open cell. Like weighted searches it runs until no queued f is below the
+    /// target distance.
+    bool aStar = false;
+    int fBand = 8;
+    int hWeight = 1;
+
+    /// Weighted searches keep running after the target is first reached until no
+    /// queued distance is below the best target distance, set before initializeMazeState.
+    /// Has to match the program, it also selects the two byte cell encoding.
+    bool weighted = false;
+    int32_t targetDist = -1; /// host copy of dist[target], read at sync points
+
+    /// Bidirectional BFS, only for the uniform kernel, set before initializeMazeState.
+    /// A second wavefront grows from the target in the same launch as the forward
+    /// one, the search stops at the first level where they touch.
+    bool bidirectional = false;
+
+    /// Tiled relaxation, for both kernels, set before initializeMazeState. The
+    /// wavefront lists hold tiles instead of cells and every launch relaxes the
+    /// active tiles in local memory until they converge, see expand_tiles.
+    /// Distances can still drop after they are first written, so like weighted
+    /// searches it runs until no tile is active.
+    bool tiled = false;
+    static constexpr int tileSize = 16; /// TILE in the kernels
+    int tilesX = 0;
+    int tilesY = 0;
+
     std::vector<int32_t> distHost;
-    std::vector<int32_t> visitedFlag; /// flag for backtracking state
+    std::vector<uint16_t> distView;   /// saturated 16 bit distances in device layout, 0xFFFF if unreached, padded to an even size
+    std::vector<uint16_t> distViewStaging[2]; /// host targets of the view readbacks, swapped into distView once complete
+    std::vector<int32_t> distRevHost; /// only filled by stitchBidirectionalPath
+    std::vector<int32_t> visitedFlag; /// flag for backtracking state, in device layout like the renderer reads it
     std::vector<uint8_t> foundFlagHost;
 
     cl::Kernel kernel;
+    cl::Kernel bottomUpKernel;
+    cl::Kernel nearFarKernel;
+    cl::Kernel splitFarKernel;
+    cl::Kernel bidirKernel;
+    cl::Kernel tileKernel;
+    cl::Kernel narrowKernel;
+    cl::Kernel rebuildKernel;
+    cl::Kernel invalidateKernel; /// kernels of repairDistances
+    cl::Kernel seedRepairKernel;
+    cl::Kernel clearKernel;
+    cl::Kernel relaxKernel;
 };
 
+/**
+ * @brief Create the buffers and kernels of a run, the first wavefront holds the start cell
+ * @param clContext OpenCL context
+ * @param clProgram Uniform or weighted program, has to match mazeState.weighted and layout
+ * @param hostMazeCosts Row-major cell costs, negative for walls
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIndex Row-major start cell index
+ * @param targetIndex Row-major target cell index
+ * @param mazeState State to fill, the engine options are read from it
+ * @return true on success
+ */
 bool initializeMazeState(
     const Compute::CLContext& clContext,
     const Compute::CLProgram& clProgram,
     const std::vector<int32_t>& hostMazeCosts,
-    int mazeSize, int startIndex,
+    int width, int height, int startIndex, int targetIndex,
     MazeState& mazeState
 );
 } // namespace Maze
@@ -1,76 +1,725 @@
 #include "pathfinding.h"
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace Maze {
 
+static void setExpandArgs(int width, int height, int targetIdx, MazeState& st)
+{
+    st.kernel.setArg(0, width);
+    st.kernel.setArg(1, height);
+    st.kernel.setArg(2, st.cellBuf);
+    st.kernel.setArg(3, st.prevBuf);
+    st.kernel.setArg(4, st.prevSizeBuf);
+    st.kernel.setArg(5, st.nextBuf);
+    st.kernel.setArg(6, st.nextSizeBuf);
+    st.kernel.setArg(7, st.wfCapacity);
+    st.kernel.setArg(8, st.distBuf);
+    st.kernel.setArg(9, targetIdx);
+    st.kernel.setArg(10, st.foundFlagBuf);
+}
+
+static void setBottomUpArgs(int width, int height, int targetIdx, MazeState& st)
+{
+    st.bottomUpKernel.setArg(0, width);
+    st.bottomUpKernel.setArg(1, height);
+    st.bottomUpKernel.setArg(2, st.level);
+    st.bottomUpKernel.setArg(3, st.cellBuf);
+    st.bottomUpKernel.setArg(4, st.nextBuf);
+    st.bottomUpKernel.setArg(5, st.nextSizeBuf);
+    st.bottomUpKernel.setArg(6, st.wfCapacity);
+    st.bottomUpKernel.setArg(7, st.distBuf);
+    st.bottomUpKernel.setArg(8, targetIdx);
+    st.bottomUpKernel.setArg(9, st.foundFlagBuf);
+}
+
+static void setNearFarArgs(int width, int height, int targetIdx, MazeState& st)
+{
+    st.nearFarKernel.setArg(0, width);
+    st.nearFarKernel.setArg(1, height);
+    st.nearFarKernel.setArg(2, st.cellBuf);
+    st.nearFarKernel.setArg(3, st.prevBuf);
+    st.nearFarKernel.setArg(4, st.prevSizeBuf);
+    st.nearFarKernel.setArg(5, st.nextBuf);
+    st.nearFarKernel.setArg(6, st.nextSizeBuf);
+    st.nearFarKernel.setArg(7, st.wfCapacity);
+    st.nearFarKernel.setArg(8, st.farBuf);
+    st.nearFarKernel.setArg(9, st.farSizeBuf);
+    st.nearFarKernel.setArg(10, st.farCapacity);
+    st.nearFarKernel.setArg(11, st.farFlagBuf);
+    st.nearFarKernel.setArg(12, st.farMinBuf);
+    st.nearFarKernel.setArg(13, st.threshold);
+    st.nearFarKernel.setArg(14, st.distBuf);
+    st.nearFarKernel.setArg(15, targetIdx);
+    st.nearFarKernel.setArg(16, st.foundFlagBuf);
+    if (st.aStar)
+        st.nearFarKernel.setArg(17, st.hWeight);
+}
+
+static void setSplitFarArgs(int width, int targetIdx, MazeState& st)
+{
+    st.splitFarKernel.setArg(0, st.farBuf);
+    st.splitFarKernel.setArg(1, st.farSizeBuf);
+    st.splitFarKernel.setArg(2, st.farNextBuf);
+    st.splitFarKernel.setArg(3, st.farNextSizeBuf);
+    st.splitFarKernel.setArg(4, st.farCapacity);
+    st.splitFarKernel.setArg(5, st.prevBuf);
+    st.splitFarKernel.setArg(6, st.prevSizeBuf);
+    st.splitFarKernel.setArg(7, st.wfCapacity);
+    st.splitFarKernel.setArg(8, st.farFlagBuf);
+    st.splitFarKernel.setArg(9, st.farMinBuf);
+    st.splitFarKernel.setArg(10, st.threshold);
+    st.splitFarKernel.setArg(11, st.distBuf);
+    st.splitFarKernel.setArg(12, targetIdx);
+    st.splitFarKernel.setArg(13, width);
+    st.splitFarKernel.setArg(14, st.aStar ? st.hWeight : 0);
+}
+
+static void setBidirArgs(int width, int height, MazeState& st)
+{
+    st.bidirKernel.setArg(0, width);
+    st.bidirKernel.setArg(1, height);
+    st.bidirKernel.setArg(2, st.level);
+    st.bidirKernel.setArg(3, st.cellBuf);
+    st.bidirKernel.setArg(4, st.prevBuf);
+    st.bidirKernel.setArg(5, st.prevSizeBuf);
+    st.bidirKernel.setArg(6, st.nextBuf);
+    st.bidirKernel.setArg(7, st.nextSizeBuf);
+    st.bidirKernel.setArg(8, st.revPrevBuf);
+    st.bidirKernel.setArg(9, st.revPrevSizeBuf);
+    st.bidirKernel.setArg(10, st.revNextBuf);
+    st.bidirKernel.setArg(11, st.revNextSizeBuf);
+    st.bidirKernel.setArg(12, st.wfCapacity);
+    st.bidirKernel.setArg(13, st.distBuf);
+    st.bidirKernel.setArg(14, st.distRevBuf);
+    st.bidirKernel.setArg(15, st.meetBuf);
+    st.bidirKernel.setArg(16, st.foundFlagBuf);
+}
+
+static void setTileArgs(int width, int height, int targetIdx, MazeState& st)
+{
+    st.tileKernel.setArg(0, width);
+    st.tileKernel.setArg(1, height);
+    st.tileKernel.setArg(2, st.cellBuf);
+    st.tileKernel.setArg(3, st.prevBuf);
+    st.tileKernel.setArg(4, st.prevSizeBuf);
+    st.tileKernel.setArg(5, st.nextBuf);
+    st.tileKernel.setArg(6, st.nextSizeBuf);
+    st.tileKernel.setArg(7, st.wfCapacity);
+    st.tileKernel.setArg(8, st.tileFlagBuf);
+    st.tileKernel.setArg(9, st.distBuf);
+    st.tileKernel.setArg(10, targetIdx);
+    st.tileKernel.setArg(11, st.foundFlagBuf);
+}
+
+/**
+ * @brief Whether the run keeps cells waiting in the far pile, for delta-stepping and A*
+ */
+static bool usesFarPile(const MazeState& st)
+{
+    return st.deltaStepping || st.aStar;
+}
+
+/**
+ * @brief Whether the run continues after reaching the target until the bound prunes every entry
+ */
+static bool searchesToBound(const MazeState& st)
+{
+    return st.weighted || st.aStar || st.tiled;
+}
+
+/**
+ * @brief Number of wavefront entries a single step can launch, both wavefronts for bidirectional runs
+ */
+static int frontierCapacity(const MazeState& st)
+{
+    return st.bidirectional ? 2 * st.wfCapacity : st.wfCapacity;
+}
+
+/**
+ * @brief Upper bound of the next wavefront size, a cell appends at most its 4
+ * neighbors, a tile its 4 neighbors and itself
+ */
+static int growFrontierBound(int wfBound, const MazeState& st)
+{
+    const int64_t growth = st.tiled ? 5 : 4;
+    return static_cast<int>(std::min<int64_t>(growth * wfBound, frontierCapacity(st)));
+}
+
+/**
+ * @brief Pick the direction of the next steps from an exact wavefront size
+ */
+static void chooseDirection(int wfSize, MazeState& st)
+{
+    if (!st.directionOptimizing)
+        return;
+
+    if (!st.bottomUp)
+    {
+        // Also go bottom-up when the next index list could overflow,
+        // the bottom-up pass does not depend on the list
+        st.bottomUp = wfSize > st.openCells / st.buAlpha
+            || 4ll * wfSize > st.wfCapacity;
+    }
+    else
+    {
+        // The index list is complete only if it did not overflow
+        st.bottomUp = wfSize >= st.openCells / st.buBeta
+            || wfSize > st.wfCapacity;
+    }
+}
+
+/**
+ * @brief Enqueue one expansion step and make the next wavefront the previous one
+ */
+static void enqueueExpand(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int targetIdx,
+    int wfSize,
+    MazeState& st)
+{
+    // Reset next wavefront counter
+    queue.enqueueFillBuffer(st.nextSizeBuf, 0, 0, sizeof(int32_t));
+
+    if (st.bidirectional)
+    {
+        queue.enqueueFillBuffer(st.revNextSizeBuf, 0, 0, sizeof(int32_t));
+        setBidirArgs(width, height, st);
+        queue.enqueueNDRangeKernel(st.bidirKernel, cl::NullRange, cl::NDRange(wfSize), cl::NullRange);
+
+        std::swap(st.revPrevBuf, st.revNextBuf);
+        std::swap(st.revPrevSizeBuf, st.revNextSizeBuf);
+    }
+    else if (st.bottomUp)
+    {
+        setBottomUpArgs(width, height, targetIdx, st);
+        queue.enqueueNDRangeKernel(st.bottomUpKernel, cl::NullRange, cl::NDRange(st.deviceCells), cl::NullRange);
+    }
+    else if (st.tiled)
+    {
+        // One work-group per active tile
+        const int groupSize = MazeState::tileSize * MazeState::tileSize;
+        setTileArgs(width, height, targetIdx, st);
+        queue.enqueueNDRangeKernel(st.tileKernel, cl::NullRange,
+            cl::NDRange(static_cast<size_t>(wfSize) * groupSize), cl::NDRange(groupSize));
+    }
+    else if (usesFarPile(st))
+    {
+        setNearFarArgs(width, height, targetIdx, st);
+        queue.enqueueNDRangeKernel(st.nearFarKernel, cl::NullRange, cl::NDRange(wfSize), cl::NullRange);
+    }
+    else
+    {
+        setExpandArgs(width, height, targetIdx, st);
+        queue.enqueueNDRangeKernel(st.kernel, cl::NullRange, cl::NDRange(wfSize), cl::NullRange);
+    }
+
+    std::swap(st.prevBuf, st.nextBuf);
+    std::swap(st.prevSizeBuf, st.nextSizeBuf);
+    ++st.level;
+}
+
+/**
+ * @brief Read the found flag and the wavefront sizes at a single sync point
+ * @return true if the target was found
+ */
+static bool readWavefrontState(cl::CommandQueue& queue, int targetIdx, MazeState& st, int& wfSize, bool& overflowed)
+{
+    int32_t size = 0;
+    int32_t revSize = 0;
+    queue.enqueueReadBuffer(st.foundFlagBuf, CL_FALSE, 0, sizeof(uint8_t), st.foundFlagHost.data());
+    if (searchesToBound(st))
+        queue.enqueueReadBuffer(st.distBuf, CL_FALSE, sizeof(int32_t) * targetIdx, sizeof(int32_t), &st.targetDist);
+    if (usesFarPile(st))
+    {
+        queue.enqueueReadBuffer(st.farSizeBuf, CL_FALSE, 0, sizeof(int32_t), &st.farSize);
+        queue.enqueueReadBuffer(st.farMinBuf, CL_FALSE, 0, sizeof(int32_t), &st.farMin);
+    }
+    if (st.bidirectional)
+        queue.enqueueReadBuffer(st.revPrevSizeBuf, CL_FALSE, 0, sizeof(int32_t), &revSize);
+    // The swapped prev counter holds the size of the new wavefront
+    queue.enqueueReadBuffer(st.prevSizeBuf, CL_TRUE, 0, sizeof(int32_t), &size);
+
+    // Near lists spill into the far pile, tile lists hold every tile and
+    // bottom-up steps do not need a list, only plain lists lose entries
+    overflowed = !usesFarPile(st) && !st.tiled && !st.bottomUp
+        && (size > st.wfCapacity || revSize > st.wfCapacity);
+    wfSize = size;
+    if (st.bidirectional)
+    {
+        // Once either side runs dry the two can no longer meet
+        wfSize = (size == 0 || revSize == 0) ? 0 : size + revSize;
+    }
+    return st.foundFlagHost[0] != 0;
+}
+
+/**
+ * @brief Refill an empty near wavefront from the far pile with the next bucket
+ */
+static void advanceBucket(cl::CommandQueue& queue, int width, int targetIdx, MazeState& st, int& wfSize)
+{
+    while (usesFarPile(st) && wfSize == 0 && st.farSize > 0)
+    {
+        // Nothing left in the far pile can improve the target distance
+        if (st.targetDist >= 0 && st.farMin >= st.targetDist)
+        {
+            st.farSize = 0;
+            break;
+        }
+
+        // Jump straight to the bucket of the smallest far distance
+        const int bucketWidth = st.aStar ? st.fBand : st.delta;
+        const int64_t bucketEnd = (static_cast<int64_t>(st.farMin) / bucketWidth + 1) * bucketWidth;
+        st.threshold = static_cast<int>(std::max<int64_t>(st.threshold,
+            std::min<int64_t>(bucketEnd, std::numeric_limits<int32_t>::max())));
+
+        queue.enqueueFillBuffer(st.prevSizeBuf, 0, 0, sizeof(int32_t));
+        queue.enqueueFillBuffer(st.farNextSizeBuf, 0, 0, sizeof(int32_t));
+        queue.enqueueFillBuffer(st.farMinBuf, std::numeric_limits<int32_t>::max(), 0, sizeof(int32_t));
+
+        setSplitFarArgs(width, targetIdx, st);
+        queue.enqueueNDRangeKernel(st.splitFarKernel, cl::NullRange,
+            cl::NDRange(std::min(st.farSize, st.farCapacity)), cl::NullRange);
+
+        std::swap(st.farBuf, st.farNextBuf);
+        std::swap(st.farSizeBuf, st.farNextSizeBuf);
+
+        bool overflowed = false;
+        readWavefrontState(queue, targetIdx, st, wfSize, overflowed);
+    }
+}
+
+static void setRebuildArgs(
+    int width,
+    int height,
+    int targetIdx,
+    const cl::Buffer& distBuf,
+    const cl::Buffer& wfBuf,
+    const cl::Buffer& wfSizeBuf,
+    MazeState& st)
+{
+    st.rebuildKernel.setArg(0, width);
+    st.rebuildKernel.setArg(1, height);
+    st.rebuildKernel.setArg(2, st.cellBuf);
+    st.rebuildKernel.setArg(3, distBuf);
+    st.rebuildKernel.setArg(4, wfBuf);
+    st.rebuildKernel.setArg(5, wfSizeBuf);
+    st.rebuildKernel.setArg(6, st.wfCapacity);
+    st.rebuildKernel.setArg(7, targetIdx);
+    st.rebuildKernel.setArg(8, st.levelBuf);
+}
+
+/**
+ * @brief Refill the wavefront lists at their current capacity
+ * @return false if a rebuilt list did not fit
+ */
+static bool refillLists(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int targetIdx,
+    MazeState& st,
+    int32_t& size,
+    int32_t& revSize)
+{
+    queue.enqueueFillBuffer(st.prevSizeBuf, 0, 0, sizeof(int32_t));
+    queue.enqueueFillBuffer(st.levelBuf, -1, 0, sizeof(int32_t));
+
+    // Bidirectional fronts have no target, they stop where they meet
+    setRebuildArgs(width, height, st.bidirectional ? -1 : targetIdx, st.distBuf, st.prevBuf, st.prevSizeBuf, st);
+    queue.enqueueNDRangeKernel(st.rebuildKernel, cl::NullRange, cl::NDRange(st.deviceCells), cl::NullRange);
+
+    revSize = 0;
+    if (st.bidirectional)
+    {
+        queue.enqueueFillBuffer(st.revPrevSizeBuf, 0, 0, sizeof(int32_t));
+
+        setRebuildArgs(width, height, -1, st.distRevBuf, st.revPrevBuf, st.revPrevSizeBuf, st);
+        queue.enqueueNDRangeKernel(st.rebuildKernel, cl::NullRange, cl::NDRange(st.deviceCells), cl::NullRange);
+        queue.enqueueReadBuffer(st.revPrevSizeBuf, CL_FALSE, 0, sizeof(int32_t), &revSize);
+    }
+
+    int32_t level = -1;
+    queue.enqueueReadBuffer(st.levelBuf, CL_FALSE, 0, sizeof(int32_t), &level);
+    queue.enqueueReadBuffer(st.prevSizeBuf, CL_TRUE, 0, sizeof(int32_t), &size);
+
+    // Steps queued after the overflow did nothing, uniform runs resume at the level of the lost list
+    if (!st.weighted && level >= 0)
+        st.level = level;
+
+    return size <= st.wfCapacity && revSize <= st.wfCapacity;
+}
+
+/**
+ * @brief Grow the wavefront lists to fit the rebuilt sizes, their contents are lost
+ */
+static void growLists(const cl::Context& context, MazeState& st, int32_t size, int32_t revSize)
+{
+    const int64_t wanted = std::max<int64_t>(2ll * st.wfCapacity, std::max(size, revSize));
+    st.wfCapacity = static_cast<int>(std::min<int64_t>(wanted, st.deviceCells));
+    ++st.wfGrowths;
+
+    st.prevBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+    st.nextBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+    if (st.bidirectional)
+    {
+        st.revPrevBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+        st.revNextBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.wfCapacity);
+    }
+}
+
+static int rebuiltSize(const MazeState& st, int32_t size, int32_t revSize)
+{
+    if (st.bidirectional)
+        return (size == 0 || revSize == 0) ? 0 : size + revSize;
+    return size;
+}
+
+void rebuildFrontier(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int targetIdx,
+    MazeState& st,
+    int& wfSize)
+{
+    const cl::Context context = queue.getInfo<CL_QUEUE_CONTEXT>();
+    int32_t size = st.wfCapacity + 1;
+    int32_t revSize = 0;
+    do
+    {
+        growLists(context, st, size, revSize);
+    }
+    while (!refillLists(queue, width, height, targetIdx, st, size, revSize));
+
+    std::cout << "Wavefront overflowed, lists grown to " << st.wfCapacity << " entries" << std::endl;
+
+    wfSize = rebuiltSize(st, size, revSize);
+}
+
+void refillFrontier(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int targetIdx,
+    MazeState& st,
+    int& wfSize)
+{
+    int32_t size = 0;
+    int32_t revSize = 0;
+    if (!refillLists(queue, width, height, targetIdx, st, size, revSize))
+    {
+        const cl::Context context = queue.getInfo<CL_QUEUE_CONTEXT>();
+        do
+        {
+            growLists(context, st, size, revSize);
+        }
+        while (!refillLists(queue, width, height, targetIdx, st, size, revSize));
+
+        std::cout << "Wavefront overflowed, lists grown to " << st.wfCapacity << " entries" << std::endl;
+    }
+
+    wfSize = rebuiltSize(st, size, revSize);
+}
+
 bool stepPathfinding(
     int step,
-    int size,
+    int width,
+    int height,
     int& currentWfSize,
     cl::CommandQueue& queue,
-    cl::Kernel& kernel,
     int targetIdx,
-    const cl::Buffer& costBuf,
-    cl::Buffer& prevBuf,
-    cl::Buffer& nextBuf,
-    cl::Buffer& distBuf,
-    cl::Buffer& foundFlagBuf,
-    std::vector<int32_t>& prevHost,
-    std::vector<int32_t>& nextHost,
-    std::vector<int32_t>& distHost,
-    std::vector<uint8_t>& foundFlagHost
+    MazeState& mazeState
 )
 {
-    // Set kernel arguments
-    kernel.setArg(0, size);
-    kernel.setArg(1, size);
-    kernel.setArg(2, currentWfSize);
-    kernel.setArg(3, costBuf);
-    kernel.setArg(4, prevBuf);
-    kernel.setArg(5, nextBuf);
-    kernel.setArg(6, distBuf);
-    kernel.setArg(7, targetIdx);
-    kernel.setArg(8, foundFlagBuf);
+    auto& st = mazeState;
+
+    if (currentWfSize == 0)
+        return false;
 
-    // Run kernel
-    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(currentWfSize), cl::NullRange);
-    queue.enqueueReadBuffer(foundFlagBuf, CL_TRUE, 0, sizeof(uint8_t), foundFlagHost.data());
+    // The kernels compare storage indices
+    targetIdx = deviceIndex(st.layout, width, targetIdx);
 
-    if (foundFlagHost[0])
+    chooseDirection(currentWfSize, st);
+    enqueueExpand(queue, width, height, targetIdx, std::min(currentWfSize, frontierCapacity(st)), st);
+
+    bool overflowed = false;
+    bool found = readWavefrontState(queue, targetIdx, st, currentWfSize, overflowed);
+    if (!searchesToBound(st) && found)
     {
         std::cout << "Target found at step " << step << std::endl;
         return true;
     }
 
-    // Reset prev buffer
-    std::fill(prevHost.begin(), prevHost.end(), -1);
-    queue.enqueueWriteBuffer(prevBuf, CL_TRUE, 0, sizeof(int32_t) * prevHost.size(), prevHost.data());
-
-    // Read next wavefront
-    queue.enqueueReadBuffer(nextBuf, CL_TRUE, 0, sizeof(int32_t) * nextHost.size(), nextHost.data());
+    if (overflowed)
+        rebuildFrontier(queue, width, height, targetIdx, st, currentWfSize);
 
-    // Count valid next elements
-    std::vector<int32_t> nextPacked;
-    for (auto val : nextHost)
-        if (val != -1)
-            nextPacked.push_back(val);
+    // Weighted, A* and tiled searches only stop once the frontier is exhausted, the kernels
+    // drop every entry that cannot beat the current target distance
+    advanceBucket(queue, width, targetIdx, st, currentWfSize);
+    if (currentWfSize != 0)
+        return false;
 
-    currentWfSize = static_cast<int>(nextPacked.size());
-    if (currentWfSize == 0)
+    if (found)
     {
-        std::cout << "No more cells to expand - path not found." << std::endl;
-        return false;
+        std::cout << "Target found at step " << step << " with distance " << st.targetDist << std::endl;
+        return true;
     }
 
-    // Copy valid next into prev
-    queue.enqueueWriteBuffer(prevBuf, CL_TRUE, 0, sizeof(int32_t) * nextPacked.size(), nextPacked.data());
+    std::cout << "No more cells to expand - path not found." << std::endl;
+    return false;
+}
+
+bool runPathfinding(
+    int& step,
+    int width,
+    int height,
+    int& currentWfSize,
+    cl::CommandQueue& queue,
+    int targetIdx,
+    MazeState& mazeState,
+    int maxSteps,
+    int syncInterval
+)
+{
+    auto& st = mazeState;
+    syncInterval = std::max(syncInterval, 1);
+
+    // The kernels compare storage indices
+    targetIdx = deviceIndex(st.layout, width, targetIdx);
+
+    // Bounds the wavefront size on the device without reading it back
+    int wfBound = std::min(currentWfSize, frontierCapacity(st));
+    int queued = 0;
+
+    // The direction is only switched at sync points, where the size is exact
+    chooseDirection(currentWfSize, st);
+
+    while (currentWfSize > 0 && (maxSteps <= 0 || queued < maxSteps))
+    {
+        enqueueExpand(queue, width, height, targetIdx, wfBound, st);
+
+        ++queued;
+        ++step;
+        wfBound = growFrontierBound(wfBound, st);
+
+        if (queued % syncInterval != 0 && queued != maxSteps)
+            continue;
 
-    // Reset next buffer
-    std::fill(nextHost.begin(), nextHost.end(), -1);
-    queue.enqueueWriteBuffer(nextBuf, CL_TRUE, 0, sizeof(int32_t) * nextHost.size(), nextHost.data());
+        // Sync point
+        bool overflowed = false;
+        bool found = readWavefrontState(queue, targetIdx, st, currentWfSize, overflowed);
+        if (!searchesToBound(st) && found)
+        {
+            std::cout << "Target found by step " << step << std::endl;
+            return true;
+        }
+
+        if (overflowed)
+            rebuildFrontier(queue, width, height, targetIdx, st, currentWfSize);
+        advanceBucket(queue, width, targetIdx, st, currentWfSize);
+        wfBound = std::min(currentWfSize, frontierCapacity(st));
+        if (currentWfSize == 0)
+        {
+            if (found)
+            {
+                std::cout << "Target found by step " << step << " with distance " << st.targetDist << std::endl;
+                return true;
+            }
+            std::cout << "No more cells to expand - path not found." << std::endl;
+            return false;
+        }
+
+        chooseDirection(currentWfSize, st);
+    }
 
     return false;
 }
 
+void readDistanceView(cl::CommandQueue& queue, cl::CommandQueue& transferQueue, MazeState& mazeState)
+{
+    auto& st = mazeState;
+    const int cells = st.deviceCells;
+    const int slot = st.distViewSlot;
+    const int previous = 1 - slot;
+
+    // The buffer is free once its last readback completed, the device waits for that, not the host
+    std::vector<cl::Event> viewFree;
+    if (st.distViewEvents[slot]())
+        viewFree.push_back(st.distViewEvents[slot]);
+
+    cl::Event narrowed;
+    st.narrowKernel.setArg(0, cells);
+    st.narrowKernel.setArg(1, st.distBuf);
+    st.narrowKernel.setArg(2, st.distViewBufs[slot]);
+    queue.enqueueNDRangeKernel(st.narrowKernel, cl::NullRange, cl::NDRange(cells), cl::NullRange,
+        viewFree.empty() ? nullptr : &viewFree, &narrowed);
+
+    const std::vector<cl::Event> readAfter = { narrowed };
+    transferQueue.enqueueReadBuffer(st.distViewBufs[slot], CL_FALSE, 0, sizeof(uint16_t) * cells,
+        st.distViewStaging[slot].data(), &readAfter, &st.distViewEvents[slot]);
+    queue.flush();
+    transferQueue.flush();
+
+    // Show the view requested by the previous call
+    if (st.distViewEvents[previous]())
+    {
+        st.distViewEvents[previous].wait();
+        std::swap(st.distView, st.distViewStaging[previous]);
+    }
+    st.distViewSlot = previous;
+}
+
+void narrowDistances(const std::vector<int32_t>& dist, int width, int height, int layout, std::vector<uint16_t>& view)
+{
+    std::vector<uint16_t> narrow(dist.size());
+    std::transform(dist.begin(), dist.end(), narrow.begin(), [](int32_t d)
+    {
+        return d < 0 ? uint16_t(0xFFFF) : static_cast<uint16_t>(std::min(d, 0xFFFE));
+    });
+
+    view = toDeviceLayout(narrow, width, height, layout, uint16_t(0xFFFF));
+    if (view.size() % 2 != 0)
+        view.push_back(0xFFFF);
+}
+
+void readDistances(
+    cl::CommandQueue& queue,
+    const cl::Buffer& distBuf,
+    int width,
+    int height,
+    int layout,
+    std::vector<int32_t>& dist
+)
+{
+    dist.resize(static_cast<size_t>(width) * height);
+    if (layout == LAYOUT_ROW_MAJOR)
+    {
+        queue.enqueueReadBuffer(distBuf, CL_TRUE, 0, sizeof(int32_t) * dist.size(), dist.data());
+        return;
+    }
+
+    std::vector<int32_t> device(layout_cells(layout, width, height));
+    queue.enqueueReadBuffer(distBuf, CL_TRUE, 0, sizeof(int32_t) * device.size(), device.data());
+    fromDeviceLayout(device, width, height, layout, dist);
+}
+
+std::vector<int32_t> extractPath(
+    const std::vector<int32_t>& dist,
+    const std::vector<int32_t>& costs,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    bool weighted
+)
+{
+    std::vector<int32_t> path;
+    if (dist[targetIdx] < 0)
+        return path;
+
+    const int cells = width * height;
+    const int offsets[] = { -1, 1, -width, width };
+    int cell = targetIdx;
+    path.push_back(cell);
+
+    // Every step strictly lowers the distance, a path can not be longer than the grid
+    while (cell != startIdx && path.size() <= dist.size())
+    {
+        const int x = cell % width;
+        const int32_t step = weighted ? costs[cell] : 1;
+        int prev = -1;
+        for (int k = 0; k < 4 && prev < 0; ++k)
+        {
+            const int n = cell + offsets[k];
+            if ((k == 0 && x == 0) || (k == 1 && x == width - 1) || n < 0 || n >= cells)
+                continue;
+            if (dist[n] >= 0 && costs[n] >= 0 && dist[n] + step == dist[cell])
+                prev = n;
+        }
+
+        if (prev < 0)
+        {
+            std::cerr << "No predecessor for cell " << cell << ", distance field is incomplete." << std::endl;
+            return {};
+        }
+
+        cell = prev;
+        path.push_back(cell);
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::vector<int32_t> stitchBidirectionalPath(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    MazeState& mazeState
+)
+{
+    auto& st = mazeState;
+    std::vector<int32_t> path;
+
+    int32_t meet[4];
+    queue.enqueueReadBuffer(st.meetBuf, CL_FALSE, 0, sizeof(meet), meet);
+    readDistances(queue, st.distBuf, width, height, st.layout, st.distHost);
+    readDistances(queue, st.distRevBuf, width, height, st.layout, st.distRevHost);
+
+    // The shortest candidate of the meeting level
+    int edge = -1;
+    for (int t = 1; t < 4 && edge < 0; ++t)
+        edge = meet[t];
+    if (edge < 0)
+        return path;
+
+    // The edge holds the storage index of its forward cell
+    const int cells = width * height;
+    const int offsets[] = { -1, 1, -width, width };
+    const int fwdCell = rowMajorIndex(st.layout, width, edge / 4);
+    const int revCell = fwdCell + offsets[edge % 4];
+
+    // Walk each distance field down to its source, every step lowers it by one
+    auto descend = [&](int cell, const std::vector<int32_t>& dist, std::vector<int32_t>& out)
+    {
+        out.push_back(cell);
+        while (dist[cell] > 0)
+        {
+            const int x = cell % width;
+            int next = -1;
+            for (int k = 0; k < 4 && next < 0; ++k)
+            {
+                const int n = cell + offsets[k];
+                if ((k == 0 && x == 0) || (k == 1 && x == width - 1) || n < 0 || n >= cells)
+                    continue;
+                if (dist[n] == dist[cell] - 1)
+                    next = n;
+            }
+            if (next < 0)
+            {
+                std::cerr << "No predecessor for cell " << cell << ", distance field is incomplete." << std::endl;
+                return false;
+            }
+            cell = next;
+            out.push_back(cell);
+        }
+        return true;
+    };
+
+    if (!descend(fwdCell, st.distHost, path))
+        return {};
+    std::reverse(path.begin(), path.end());
+    if (!descend(revCell, st.distRevHost, path))
+        return {};
+
+    std::cout << "Fronts met between " << fwdCell << " and " << revCell
+              << ", path length " << path.size() - 1 << std::endl;
+
+    return path;
+}
+
 } // namespace Maze
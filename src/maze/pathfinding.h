@@ -5,43 +5,203 @@
 #include <vector>
 #include <cstdint>
 
+#include "maze.h"
+
 namespace Maze {
 
 /**
  * @brief Execute one step of wavefront pathfinding
+ * 
+ * The next wavefront is compacted on the device, the only data read back
+ * per step is the found flag and the size of the next wavefront. When a
+ * wavefront outgrew its lists they are grown and rebuilt from the distances.
+ * Weighted, A* and tiled runs also read the target distance and keep going after the
+ * target is reached, until no queued entry can lower that distance.
+ * 
  * @param step Current step number
- * @param size Maze size
+ * @param width Maze width
+ * @param height Maze height
  * @param currentWfSize Current wavefront size (will be updated)
  * @param queue OpenCL command queue
- * @param kernel OpenCL kernel for wavefront expansion
  * @param targetIdx Target cell index
- * @param costBuf OpenCL buffer containing wall data
- * @param prevBuf OpenCL buffer for previous wavefront
- * @param nextBuf OpenCL buffer for next wavefront
- * @param distBuf OpenCL buffer for distance data
- * @param foundFlagBuf OpenCL buffer for found flag
- * @param prevHost Host buffer for previous wavefront
- * @param nextHost Host buffer for next wavefront
- * @param distHost Host buffer for distances
- * @param foundFlagHost Host buffer for found flag
+ * @param mazeState Buffers and kernel of the run (prev/next wavefronts are swapped)
  * @return true if target found, false otherwise
  */
 bool stepPathfinding(
     int step,
-    int size,
+    int width,
+    int height,
+    int& currentWfSize,
+    cl::CommandQueue& queue,
+    int targetIdx,
+    MazeState& mazeState
+);
+
+/**
+ * @brief Queue several wavefront steps back to back
+ * 
+ * Steps between sync points are launched over an upper bound of the wavefront
+ * size, the found flag and the wavefront size are only read back every
+ * syncInterval steps and after the last step.
+ * 
+ * @param step Current step number (advanced by the number of queued steps)
+ * @param width Maze width
+ * @param height Maze height
+ * @param currentWfSize Current wavefront size (updated at sync points)
+ * @param queue OpenCL command queue
+ * @param targetIdx Target cell index
+ * @param mazeState Buffers and kernel of the run
+ * @param maxSteps Number of steps to queue, 0 or less runs until the search ends
+ * @param syncInterval Number of steps between two host synchronizations
+ * @return true if target found, false otherwise
+ */
+bool runPathfinding(
+    int& step,
+    int width,
+    int height,
     int& currentWfSize,
     cl::CommandQueue& queue,
-    cl::Kernel& kernel,
     int targetIdx,
-    const cl::Buffer& costBuf,
-    cl::Buffer& prevBuf,
-    cl::Buffer& nextBuf,
-    cl::Buffer& distBuf,
-    cl::Buffer& foundFlagBuf,
-    std::vector<int32_t>& prevHost,
-    std::vector<int32_t>& nextHost,
-    std::vector<int32_t>& distHost,
-    std::vector<uint8_t>& foundFlagHost
+    MazeState& mazeState,
+    int maxSteps,
+    int syncInterval
+);
+
+/**
+ * @brief Grow the wavefront lists after one overflowed and refill them from the distances
+ *
+ * The kernels stop touching the lists once one overflowed (wave_overflowed),
+ * so the distances hold everything the lost entries would have carried. The
+ * rebuilt lists are launched over every cell and hold each reached cell that
+ * can still lower a neighbor, which for uniform runs is the last level.
+ * Every cell is at most once in a rebuilt list, so the capacity never has to
+ * grow past the number of cells.
+ *
+ * @param queue OpenCL command queue
+ * @param width Maze width
+ * @param height Maze height
+ * @param targetIdx Target storage index
+ * @param mazeState State of the run, prevBuf receives the rebuilt wavefront
+ * @param wfSize Receives the size of the rebuilt wavefront
+ */
+void rebuildFrontier(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int targetIdx,
+    MazeState& mazeState,
+    int& wfSize
+);
+
+/**
+ * @brief Refill the wavefront lists from the distances, growing them only if the rebuilt list does not fit
+ *
+ * For callers that changed the distances themselves and need the reached
+ * cells that can still lower a neighbor, while the lists did not overflow.
+ *
+ * @param queue OpenCL command queue
+ * @param width Maze width
+ * @param height Maze height
+ * @param targetIdx Target storage index
+ * @param mazeState State of the run, prevBuf receives the rebuilt wavefront
+ * @param wfSize Receives the size of the rebuilt wavefront
+ */
+void refillFrontier(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int targetIdx,
+    MazeState& mazeState,
+    int& wfSize
+);
+
+/**
+ * @brief Fill distView from the device distances without reading the full field
+ *
+ * The view is narrowed into one of two device buffers on the compute queue and
+ * read back on the transfer queue once the narrowing event completed, so the
+ * copy overlaps the steps queued afterwards. distView receives the view of the
+ * previous call, which had a whole frame to arrive, and lags one call behind.
+ * Passing the same queue twice reads in order.
+ *
+ * @param queue OpenCL command queue of the steps
+ * @param transferQueue Queue of the readbacks, on the same context
+ * @param mazeState State of the run
+ */
+void readDistanceView(cl::CommandQueue& queue, cl::CommandQueue& transferQueue, MazeState& mazeState);
+
+/**
+ * @brief Saturate distances to the 16 bit view of the renderer, 0xFFFF marks unreached cells
+ * @param dist Row-major distances, -1 for unreached cells
+ * @param width Maze width
+ * @param height Maze height
+ * @param layout Cell layout of the renderer buffers
+ * @param view Output in that layout, padded to an even size
+ */
+void narrowDistances(const std::vector<int32_t>& dist, int width, int height, int layout, std::vector<uint16_t>& view);
+
+/**
+ * @brief Read a device distance field into row-major order
+ * @param queue OpenCL command queue, the read blocks
+ * @param distBuf Distances in device layout
+ * @param width Maze width
+ * @param height Maze height
+ * @param layout Cell layout of the buffer
+ * @param dist Receives width * height distances
+ */
+void readDistances(
+    cl::CommandQueue& queue,
+    const cl::Buffer& distBuf,
+    int width,
+    int height,
+    int layout,
+    std::vector<int32_t>& dist
+);
+
+/**
+ * @brief Extract the shortest path from a final distance field
+ * 
+ * Walks back from the target, the predecessor of a cell is a neighbor whose
+ * distance plus the step cost into the cell equals the distance of the cell.
+ * The uniform kernel counts every step as 1 whatever the costs say, so the
+ * step cost follows the kernel that built the field.
+ * 
+ * @param dist Distances from the start, -1 for unreached cells
+ * @param costs Cell costs, negative for walls
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Start cell index
+ * @param targetIdx Target cell index
+ * @param weighted true if the weighted kernel built dist (MazeState::weighted), false for unit steps
+ * @return Cell indices from start to target, empty if the target was not reached
+ */
+std::vector<int32_t> extractPath(
+    const std::vector<int32_t>& dist,
+    const std::vector<int32_t>& costs,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    bool weighted
+);
+
+/**
+ * @brief Build the path of a bidirectional run once the wavefronts met
+ * 
+ * Reads both distance fields into distHost and distRevHost and joins the
+ * forward half ending at the meeting edge with the reverse half.
+ * 
+ * @param queue OpenCL command queue
+ * @param width Maze width
+ * @param height Maze height
+ * @param mazeState State of a bidirectional run
+ * @return Cell indices from start to target, empty if the wavefronts did not meet
+ */
+std::vector<int32_t> stitchBidirectionalPath(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    MazeState& mazeState
 );
 
 } // namespace Maze
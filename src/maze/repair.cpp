@@ -0,0 +1,253 @@
+#include "repair.h"
+#include "pathfinding.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Maze {
+
+static void setInvalidateArgs(int width, int height, int begin, int count, MazeState& st)
+{
+    st.invalidateKernel.setArg(0, width);
+    st.invalidateKernel.setArg(1, height);
+    st.invalidateKernel.setArg(2, st.cellBuf);
+    st.invalidateKernel.setArg(3, st.repairBuf);
+    st.invalidateKernel.setArg(4, begin);
+    st.invalidateKernel.setArg(5, count);
+    st.invalidateKernel.setArg(6, st.repairSizeBuf);
+    st.invalidateKernel.setArg(7, st.deviceCells);
+    st.invalidateKernel.setArg(8, st.distBuf);
+}
+
+static void setSeedRepairArgs(int width, int height, int count, MazeState& st)
+{
+    st.seedRepairKernel.setArg(0, width);
+    st.seedRepairKernel.setArg(1, height);
+    st.seedRepairKernel.setArg(2, st.repairBuf);
+    st.seedRepairKernel.setArg(3, count);
+    st.seedRepairKernel.setArg(4, st.prevBuf);
+    st.seedRepairKernel.setArg(5, st.prevSizeBuf);
+    st.seedRepairKernel.setArg(6, st.wfCapacity);
+    st.seedRepairKernel.setArg(7, st.distBuf);
+}
+
+static void setRelaxArgs(int width, int height, int targetIdx, MazeState& st)
+{
+    st.relaxKernel.setArg(0, width);
+    st.relaxKernel.setArg(1, height);
+    st.relaxKernel.setArg(2, st.cellBuf);
+    st.relaxKernel.setArg(3, st.prevBuf);
+    st.relaxKernel.setArg(4, st.prevSizeBuf);
+    st.relaxKernel.setArg(5, st.nextBuf);
+    st.relaxKernel.setArg(6, st.nextSizeBuf);
+    st.relaxKernel.setArg(7, st.wfCapacity);
+    st.relaxKernel.setArg(8, st.distBuf);
+    st.relaxKernel.setArg(9, targetIdx);
+    st.relaxKernel.setArg(10, st.foundFlagBuf);
+}
+
+/**
+ * @brief Read the size of the wavefront in prevBuf, rebuilding the list if it overflowed
+ */
+static int readRepairWavefront(cl::CommandQueue& queue, int width, int height, int targetIdx, MazeState& st)
+{
+    int32_t size = 0;
+    queue.enqueueReadBuffer(st.prevSizeBuf, CL_TRUE, 0, sizeof(int32_t), &size);
+
+    int wfSize = size;
+    if (size > st.wfCapacity)
+        rebuildFrontier(queue, width, height, targetIdx, st, wfSize);
+    return wfSize;
+}
+
+/**
+ * @brief Relax the wavefront in prevBuf until no entry can lower a distance below the target distance
+ * @return Number of launches
+ */
+static int relaxRepair(cl::CommandQueue& queue, int width, int height, int targetIdx, MazeState& st, int wfSize)
+{
+    int launches = 0;
+    while (wfSize > 0)
+    {
+        queue.enqueueFillBuffer(st.nextSizeBuf, 0, 0, sizeof(int32_t));
+        setRelaxArgs(width, height, targetIdx, st);
+        queue.enqueueNDRangeKernel(st.relaxKernel, cl::NullRange,
+            cl::NDRange(std::min(wfSize, st.wfCapacity)), cl::NullRange);
+
+        std::swap(st.prevBuf, st.nextBuf);
+        std::swap(st.prevSizeBuf, st.nextSizeBuf);
+        ++launches;
+
+        wfSize = readRepairWavefront(queue, width, height, targetIdx, st);
+    }
+    return launches;
+}
+
+bool repairDistances(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    const std::vector<CellEdit>& edits,
+    std::vector<int32_t>& hostMazeCosts,
+    MazeState& mazeState
+)
+{
+    auto& st = mazeState;
+    if (!canRepair(st))
+        return false;
+
+    for (const CellEdit& edit : edits)
+    {
+        if (edit.idx == startIdx && edit.cost < 0)
+        {
+            std::cerr << "The start cell cannot become a wall" << std::endl;
+            return false;
+        }
+    }
+
+    const cl::Context context = queue.getInfo<CL_QUEUE_CONTEXT>();
+    const int targetCell = deviceIndex(st.layout, width, targetIdx);
+
+    std::vector<int> edited;
+    for (const CellEdit& edit : edits)
+    {
+        hostMazeCosts[edit.idx] = edit.cost;
+        edited.push_back(edit.idx);
+    }
+    std::sort(edited.begin(), edited.end());
+    edited.erase(std::unique(edited.begin(), edited.end()), edited.end());
+
+    // The neighbors of an edited cell gain or lose their move into it
+    std::vector<int> touched;
+    for (int idx : edited)
+    {
+        const int x = idx % width;
+        const int y = idx / width;
+        touched.push_back(idx);
+        if (x > 0) touched.push_back(idx - 1);
+        if (x < width - 1) touched.push_back(idx + 1);
+        if (y > 0) touched.push_back(idx - width);
+        if (y < height - 1) touched.push_back(idx + width);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    // Host copies have to live until the blocking read below
+    const size_t cellSize = st.weighted ? sizeof(uint16_t) : sizeof(uint8_t);
+    std::vector<uint16_t> words(touched.size());
+    std::vector<uint8_t> moves(touched.size());
+    for (size_t i = 0; i < touched.size(); ++i)
+    {
+        words[i] = encodeCell(hostMazeCosts, width, height, touched[i] % width, touched[i] / width);
+        moves[i] = static_cast<uint8_t>(words[i]);
+        const void* cell = st.weighted ? static_cast<const void*>(&words[i]) : &moves[i];
+        queue.enqueueWriteBuffer(st.cellBuf, CL_FALSE,
+            cellSize * deviceIndex(st.layout, width, touched[i]), cellSize, cell);
+    }
+
+    // Distances before the edits
+    std::vector<int32_t> oldDist(edited.size(), -1);
+    for (size_t i = 0; i < edited.size(); ++i)
+    {
+        queue.enqueueReadBuffer(st.distBuf, CL_FALSE,
+            sizeof(int32_t) * deviceIndex(st.layout, width, edited[i]), sizeof(int32_t), &oldDist[i]);
+    }
+    int32_t oldTargetDist = -1;
+    queue.enqueueReadBuffer(st.distBuf, CL_TRUE, sizeof(int32_t) * targetCell, sizeof(int32_t), &oldTargetDist);
+
+    // Reached edited cells are invalidated, newly opened unreached ones only
+    // have to be seeded. The start keeps its distance whatever it costs.
+    std::vector<int32_t> invalid;
+    std::vector<int32_t> invalidDist;
+    std::vector<int32_t> opened;
+    for (size_t i = 0; i < edited.size(); ++i)
+    {
+        if (edited[i] == startIdx)
+            continue;
+
+        const int32_t cell = deviceIndex(st.layout, width, edited[i]);
+        if (oldDist[i] >= 0)
+        {
+            invalid.push_back(cell);
+            invalidDist.push_back(-2 - oldDist[i]);
+        }
+        else if (hostMazeCosts[edited[i]] >= 0)
+        {
+            opened.push_back(cell);
+        }
+    }
+
+    if (!st.repairBuf())
+    {
+        // Every cell is invalidated at most once
+        st.repairBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.deviceCells);
+        st.repairSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t));
+    }
+
+    int32_t count = static_cast<int32_t>(invalid.size());
+    for (size_t i = 0; i < invalid.size(); ++i)
+    {
+        queue.enqueueWriteBuffer(st.distBuf, CL_FALSE, sizeof(int32_t) * invalid[i], sizeof(int32_t), &invalidDist[i]);
+    }
+    if (count > 0)
+        queue.enqueueWriteBuffer(st.repairBuf, CL_FALSE, 0, sizeof(int32_t) * count, invalid.data());
+    queue.enqueueWriteBuffer(st.repairSizeBuf, CL_FALSE, 0, sizeof(int32_t), &count);
+
+    // Every launch invalidates the cells derived from the ones the previous launch appended
+    int32_t begin = 0;
+    while (count > begin)
+    {
+        setInvalidateArgs(width, height, begin, count - begin, st);
+        queue.enqueueNDRangeKernel(st.invalidateKernel, cl::NullRange, cl::NDRange(count - begin), cl::NullRange);
+
+        begin = count;
+        queue.enqueueReadBuffer(st.repairSizeBuf, CL_TRUE, 0, sizeof(int32_t), &count);
+    }
+    const int32_t invalidated = count;
+
+    if (!opened.empty())
+    {
+        queue.enqueueWriteBuffer(st.repairBuf, CL_FALSE, sizeof(int32_t) * count, sizeof(int32_t) * opened.size(), opened.data());
+        count += static_cast<int32_t>(opened.size());
+    }
+
+    // Refill the invalidated region from the reached cells around it
+    int launches = 0;
+    if (count > 0)
+    {
+        queue.enqueueFillBuffer(st.prevSizeBuf, 0, 0, sizeof(int32_t));
+        setSeedRepairArgs(width, height, count, st);
+        queue.enqueueNDRangeKernel(st.seedRepairKernel, cl::NullRange, cl::NDRange(count), cl::NullRange);
+
+        launches = relaxRepair(queue, width, height, targetCell, st,
+            readRepairWavefront(queue, width, height, targetCell, st));
+    }
+
+    int32_t targetDist = -1;
+    queue.enqueueReadBuffer(st.distBuf, CL_TRUE, sizeof(int32_t) * targetCell, sizeof(int32_t), &targetDist);
+
+    // The search stopped at the old target distance, cells past it can hold
+    // distances that were never lowered. If the target moved further away,
+    // drop them and expand again from the exact distances below it.
+    if (oldTargetDist >= 0 && (targetDist < 0 || targetDist > oldTargetDist))
+    {
+        st.clearKernel.setArg(0, width);
+        st.clearKernel.setArg(1, height);
+        st.clearKernel.setArg(2, st.distBuf);
+        st.clearKernel.setArg(3, oldTargetDist);
+        queue.enqueueNDRangeKernel(st.clearKernel, cl::NullRange, cl::NDRange(st.deviceCells), cl::NullRange);
+
+        int wfSize = 0;
+        refillFrontier(queue, width, height, targetCell, st, wfSize);
+        launches += relaxRepair(queue, width, height, targetCell, st, wfSize);
+        queue.enqueueReadBuffer(st.distBuf, CL_TRUE, sizeof(int32_t) * targetCell, sizeof(int32_t), &targetDist);
+    }
+    st.targetDist = targetDist;
+
+    std::cout << "Repaired " << edited.size() << " edited cells, " << invalidated << " distances invalidated, "
+        << launches << " relaxation launches, target distance " << oldTargetDist << " -> " << targetDist << std::endl;
+    return true;
+}
+
+} // namespace Maze
@@ -0,0 +1,66 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+#include <vector>
+#include <cstdint>
+
+#include "maze.h"
+
+namespace Maze {
+
+/**
+ * @brief New cost of a single cell
+ */
+struct CellEdit {
+    int idx = 0;      /// row-major cell index
+    int32_t cost = 0; /// new cost, negative for a wall
+};
+
+/**
+ * @brief Whether repairDistances can update the distances of a run
+ *
+ * Bidirectional runs only hold half of the forward field and A* leaves
+ * distances above their true value wherever the heuristic steered away.
+ * Tiled runs size their lists for tiles, the repair queues cells.
+ */
+inline bool canRepair(const MazeState& mazeState)
+{
+    return !mazeState.bidirectional && !mazeState.aStar && !mazeState.tiled;
+}
+
+/**
+ * @brief Apply cell edits to a finished run and repair its distance field in place
+ *
+ * Only the cells whose distance was derived through an edited cell are
+ * recomputed: starting at the edited cells the kernels invalidate every
+ * neighbor whose distance equals the invalidated one plus its step cost,
+ * then the invalidated region is refilled from its reached border and from
+ * newly opened cells. The work follows the size of the affected region
+ * instead of the maze. Like after a search every distance below the target
+ * distance is exact; if an edit moved the target further away, the cells
+ * the search had left at the old target distance are expanded as well.
+ *
+ * @param queue OpenCL command queue
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Row-major start cell index
+ * @param targetIdx Row-major target cell index
+ * @param edits Cells to change, later edits of a cell win
+ * @param hostMazeCosts Row-major cell costs of the run, the edits are applied to it
+ * @param mazeState State of a run that ran to completion, cellBuf and distBuf are updated
+ * @return false if the run cannot be repaired (see canRepair) or the start
+ *         becomes a wall, nothing is changed then
+ */
+bool repairDistances(
+    cl::CommandQueue& queue,
+    int width,
+    int height,
+    int startIdx,
+    int targetIdx,
+    const std::vector<CellEdit>& edits,
+    std::vector<int32_t>& hostMazeCosts,
+    MazeState& mazeState
+);
+
+} // namespace Maze
@@ -0,0 +1,340 @@
+#include "streaming.h"
+#include "maze.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Maze {
+
+/**
+ * @brief Distance file entries hold distance + 1, zero is unreached
+ */
+static int32_t* distances(StreamingState& st)
+{
+    return reinterpret_cast<int32_t*>(st.distFile.data());
+}
+
+static const int32_t* distances(const StreamingState& st)
+{
+    return reinterpret_cast<const int32_t*>(st.distFile.data());
+}
+
+static bool isOpen(const StreamingState& st, int64_t x, int64_t y)
+{
+    return x >= 0 && x < st.width && y >= 0 && y < st.height
+        && st.mazeFile.data()[y * st.width + x] != 1;
+}
+
+static int64_t pageOf(const StreamingState& st, int64_t x, int64_t y)
+{
+    return (y / st.pageSize) * st.pagesX + x / st.pageSize;
+}
+
+/**
+ * @brief Queue a page with the distance that woke it, an already queued page keeps the smaller key
+ */
+static void activatePage(StreamingState& st, int64_t page, int32_t key)
+{
+    auto it = st.activeKey.find(page);
+    if (it != st.activeKey.end() && it->second <= key)
+        return;
+
+    st.activeKey[page] = key;
+    st.activePages.push({ key, page });
+}
+
+bool initializeStreamingState(
+    const Compute::CLContext& clContext,
+    const Compute::CLProgram& clProgram,
+    const std::string& mazePath,
+    const std::string& distPath,
+    int64_t width,
+    int64_t height,
+    int64_t startIdx,
+    int64_t targetIdx,
+    StreamingState& streamingState
+)
+{
+    auto& st = streamingState;
+    const int tile = MazeState::tileSize;
+    if (st.windowSize < 2 * tile || st.windowSize % tile != 0)
+    {
+        std::cerr << "Streaming window size must be a multiple of " << tile
+                  << " and at least " << 2 * tile << "." << std::endl;
+        return false;
+    }
+
+    st.width = width;
+    st.height = height;
+    st.pageSize = st.windowSize - 2;
+    st.pagesX = (width + st.pageSize - 1) / st.pageSize;
+    st.pagesY = (height + st.pageSize - 1) / st.pageSize;
+    st.startIdx = startIdx;
+    st.targetIdx = targetIdx;
+    st.targetDist = -1;
+    st.pagesProcessed = 0;
+    st.activePages = {};
+    st.activeKey.clear();
+
+    const uint64_t cells = static_cast<uint64_t>(width) * height;
+    if (!st.mazeFile.open(mazePath, false))
+        return false;
+    if (st.mazeFile.size() < cells)
+    {
+        std::cerr << "Maze file " << mazePath << " has " << st.mazeFile.size()
+                  << " bytes, expected " << cells << "." << std::endl;
+        st.mazeFile.close();
+        return false;
+    }
+    if (!st.distFile.create(distPath, cells * sizeof(int32_t)))
+        return false;
+
+    if (!isOpen(st, startIdx % width, startIdx / width))
+    {
+        std::cerr << "Streaming start cell is a wall." << std::endl;
+        return false;
+    }
+    distances(st)[startIdx] = 1;
+    activatePage(st, pageOf(st, startIdx % width, startIdx / width), 0);
+
+    // The window is allocated once and reused for every page, one slot past
+    // the cells holds the target bound for pages that do not contain the target
+    const int window = st.windowSize;
+    st.windowCells = layout_cells(st.layout, window, window);
+    st.windowTiles = (window / tile) * (window / tile);
+    const size_t windowSlots = static_cast<size_t>(window) * window;
+    st.windowCosts.assign(windowSlots, -1);
+    st.windowDist.assign(windowSlots, -1);
+    st.windowDistBefore.assign(windowSlots, -1);
+
+    const auto& context = clContext.getContext();
+    st.cellBuf = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(uint8_t) * st.windowCells);
+    st.distBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * (st.windowCells + 1));
+    st.prevBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.windowTiles);
+    st.nextBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.windowTiles);
+    st.prevSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t));
+    st.nextSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t));
+    st.tileFlagBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * st.windowTiles);
+    st.foundFlagBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(uint8_t));
+    st.tileKernel = cl::Kernel(clProgram.getProgram(), "expand_tiles");
+
+    std::cout << "Streaming " << width << "x" << height << " maze in " << st.pagesX * st.pagesY
+              << " pages of " << st.pageSize << "x" << st.pageSize << std::endl;
+
+    return true;
+}
+
+/**
+ * @brief Copy a page and its halo to the device, relax it until no tile is active and write back improved cells
+ */
+static void processPage(cl::CommandQueue& queue, StreamingState& st, int64_t page)
+{
+    const int window = st.windowSize;
+    const int64_t x0 = (page % st.pagesX) * st.pageSize - 1;
+    const int64_t y0 = (page / st.pagesX) * st.pageSize - 1;
+    int32_t* dist = distances(st);
+
+    // Cells outside the maze are walls, encodeCells then keeps the moves inside
+    int targetWindowIdx = -1;
+    for (int y = 0; y < window; ++y)
+    {
+        for (int x = 0; x < window; ++x)
+        {
+            const size_t i = static_cast<size_t>(y) * window + x;
+            const int64_t gx = x0 + x;
+            const int64_t gy = y0 + y;
+            const bool open = isOpen(st, gx, gy);
+            st.windowCosts[i] = open ? 1 : -1;
+            st.windowDist[i] = open ? dist[gy * st.width + gx] - 1 : -1;
+            if (open && gy * st.width + gx == st.targetIdx)
+                targetWindowIdx = layout_index(st.layout, window, x, y);
+        }
+    }
+    st.windowDistBefore = st.windowDist;
+
+    const auto words = encodeCells(st.windowCosts, window, window);
+    std::vector<uint8_t> bytes(words.size());
+    std::transform(words.begin(), words.end(), bytes.begin(), [](uint16_t w) { return static_cast<uint8_t>(w); });
+    st.windowCellHost = toDeviceLayout(bytes, window, window, st.layout, uint8_t(0));
+
+    std::vector<int32_t> deviceDist = toDeviceLayout(st.windowDist, window, window, st.layout, -1);
+    deviceDist.push_back(st.targetDist);
+
+    std::vector<int32_t> tiles(st.windowTiles);
+    for (int t = 0; t < st.windowTiles; ++t)
+        tiles[t] = t;
+    int32_t tileCount = st.windowTiles;
+
+    queue.enqueueWriteBuffer(st.cellBuf, CL_FALSE, 0, sizeof(uint8_t) * st.windowCellHost.size(), st.windowCellHost.data());
+    queue.enqueueWriteBuffer(st.distBuf, CL_FALSE, 0, sizeof(int32_t) * deviceDist.size(), deviceDist.data());
+    queue.enqueueWriteBuffer(st.prevBuf, CL_FALSE, 0, sizeof(int32_t) * tiles.size(), tiles.data());
+    queue.enqueueWriteBuffer(st.prevSizeBuf, CL_FALSE, 0, sizeof(int32_t), &tileCount);
+    queue.enqueueFillBuffer(st.tileFlagBuf, 1, 0, sizeof(int32_t) * st.windowTiles);
+    queue.enqueueFillBuffer(st.foundFlagBuf, uint8_t(0), 0, sizeof(uint8_t));
+
+    // Pages without the target prune against the slot past the window
+    const int targetArg = targetWindowIdx >= 0 ? targetWindowIdx : st.windowCells;
+    st.tileKernel.setArg(0, window);
+    st.tileKernel.setArg(1, window);
+    st.tileKernel.setArg(2, st.cellBuf);
+    st.tileKernel.setArg(7, st.windowTiles);
+    st.tileKernel.setArg(8, st.tileFlagBuf);
+    st.tileKernel.setArg(9, st.distBuf);
+    st.tileKernel.setArg(10, targetArg);
+    st.tileKernel.setArg(11, st.foundFlagBuf);
+
+    // One work-group per active tile, the tile flags keep every tile at most once in the list
+    const int groupSize = MazeState::tileSize * MazeState::tileSize;
+    while (tileCount > 0)
+    {
+        queue.enqueueFillBuffer(st.nextSizeBuf, 0, 0, sizeof(int32_t));
+        st.tileKernel.setArg(3, st.prevBuf);
+        st.tileKernel.setArg(4, st.prevSizeBuf);
+        st.tileKernel.setArg(5, st.nextBuf);
+        st.tileKernel.setArg(6, st.nextSizeBuf);
+        queue.enqueueNDRangeKernel(st.tileKernel, cl::NullRange,
+            cl::NDRange(static_cast<size_t>(tileCount) * groupSize), cl::NDRange(groupSize));
+        queue.enqueueReadBuffer(st.nextSizeBuf, CL_TRUE, 0, sizeof(int32_t), &tileCount);
+
+        std::swap(st.prevBuf, st.nextBuf);
+        std::swap(st.prevSizeBuf, st.nextSizeBuf);
+    }
+
+    queue.enqueueReadBuffer(st.distBuf, CL_TRUE, 0, sizeof(int32_t) * st.windowCells, deviceDist.data());
+    deviceDist.pop_back();
+    fromDeviceLayout(deviceDist, window, window, st.layout, st.windowDist);
+
+    // Improved cells go back to the file and wake the other pages they touch:
+    // halo cells their own page, border cells the page across the border
+    static const int dx[] = { -1, 1, 0, 0 };
+    static const int dy[] = { 0, 0, -1, 1 };
+    for (int y = 0; y < window; ++y)
+    {
+        for (int x = 0; x < window; ++x)
+        {
+            const size_t i = static_cast<size_t>(y) * window + x;
+            const int32_t d = st.windowDist[i];
+            if (d == st.windowDistBefore[i])
+                continue;
+
+            const int64_t gx = x0 + x;
+            const int64_t gy = y0 + y;
+            const int64_t cell = gy * st.width + gx;
+            dist[cell] = d + 1;
+            if (cell == st.targetIdx)
+                st.targetDist = d;
+
+            const int64_t own = pageOf(st, gx, gy);
+            if (own != page)
+                activatePage(st, own, d);
+            for (int k = 0; k < 4; ++k)
+            {
+                const int64_t nx = gx + dx[k];
+                const int64_t ny = gy + dy[k];
+                if (!isOpen(st, nx, ny))
+                    continue;
+
+                const int64_t neighborPage = pageOf(st, nx, ny);
+                if (neighborPage != page && neighborPage != own)
+                    activatePage(st, neighborPage, d);
+            }
+        }
+    }
+}
+
+bool runStreaming(cl::CommandQueue& queue, StreamingState& streamingState, int maxPages)
+{
+    auto& st = streamingState;
+    int processed = 0;
+    while (!st.activePages.empty() && (maxPages <= 0 || processed < maxPages))
+    {
+        const auto [key, page] = st.activePages.top();
+        st.activePages.pop();
+
+        auto it = st.activeKey.find(page);
+        if (it == st.activeKey.end() || it->second != key)
+            continue;
+        st.activeKey.erase(it);
+
+        // Everything this page could pass on is at least key + 1
+        if (st.targetDist >= 0 && key >= st.targetDist)
+            continue;
+
+        processPage(queue, st, page);
+        ++st.pagesProcessed;
+        ++processed;
+    }
+
+    // Drop stale entries so an empty scheduler also means an empty queue
+    while (!st.activePages.empty())
+    {
+        const auto [key, page] = st.activePages.top();
+        auto it = st.activeKey.find(page);
+        if (it != st.activeKey.end() && it->second == key)
+            return false;
+        st.activePages.pop();
+    }
+
+    if (st.targetDist >= 0)
+    {
+        std::cout << "Streaming search done after " << st.pagesProcessed
+                  << " pages, target distance " << st.targetDist << std::endl;
+        return true;
+    }
+
+    std::cout << "Streaming search done after " << st.pagesProcessed << " pages - path not found." << std::endl;
+    return false;
+}
+
+size_t activePageCount(const StreamingState& streamingState)
+{
+    return streamingState.activeKey.size();
+}
+
+void readStreamingDistances(const StreamingState& streamingState, std::vector<int32_t>& dist)
+{
+    const auto& st = streamingState;
+    const int32_t* stored = distances(st);
+    dist.resize(static_cast<size_t>(st.width * st.height));
+    for (size_t i = 0; i < dist.size(); ++i)
+        dist[i] = stored[i] - 1;
+}
+
+std::vector<int64_t> extractStreamingPath(const StreamingState& streamingState)
+{
+    const auto& st = streamingState;
+    const int32_t* stored = distances(st);
+    std::vector<int64_t> path;
+    if (stored[st.targetIdx] == 0)
+        return path;
+
+    static const int dx[] = { -1, 1, 0, 0 };
+    static const int dy[] = { 0, 0, -1, 1 };
+    int64_t cell = st.targetIdx;
+    path.push_back(cell);
+    while (cell != st.startIdx)
+    {
+        const int64_t x = cell % st.width;
+        const int64_t y = cell / st.width;
+        int64_t prev = -1;
+        for (int k = 0; k < 4 && prev < 0; ++k)
+        {
+            const int64_t nx = x + dx[k];
+            const int64_t ny = y + dy[k];
+            if (isOpen(st, nx, ny) && stored[ny * st.width + nx] == stored[cell] - 1)
+                prev = ny * st.width + nx;
+        }
+        if (prev < 0)
+        {
+            std::cerr << "Streaming path broken at cell " << cell << std::endl;
+            path.clear();
+            return path;
+        }
+        cell = prev;
+        path.push_back(cell);
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+} // namespace Maze
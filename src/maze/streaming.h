@@ -0,0 +1,141 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../compute/cl_context.h"
+#include "../compute/cl_program.h"
+#include "../utils/mapped_file.h"
+#include "shared/cell_layout.h"
+
+namespace Maze {
+
+/**
+ * @brief Out-of-core search on a maze that stays in a memory-mapped file
+ *
+ * The maze is read from a file like the maze.bin of gen_maze.py, one byte per
+ * cell with 1 for walls, and every step costs 1. Distances go to a second
+ * mapped file, stored as distance + 1 so the zero pages of a fresh sparse
+ * file read as unreached. Only the pages the search touches take memory.
+ *
+ * The grid is cut into square pages. A scheduler keeps the pages whose cells
+ * or halo improved, ordered by the smallest improved distance. One page at a
+ * time is copied to the device together with a one cell halo and relaxed
+ * with expand_tiles. Improved cells are written back and wake the pages
+ * across the borders they touch, so the frontier is handed over through the
+ * halos. Device memory is one window, host memory grows with the active
+ * pages instead of the maze.
+ */
+struct StreamingState {
+    /// Side of the device window, a multiple of MazeState::tileSize, set before
+    /// initializeStreamingState. A page is the window without its halo.
+    int windowSize = 512;
+
+    /// Layout clProgram was built with, set before initializeStreamingState
+    int layout = LAYOUT_ROW_MAJOR;
+
+    int64_t width = 0;
+    int64_t height = 0;
+    int pageSize = 0;
+    int64_t pagesX = 0;
+    int64_t pagesY = 0;
+
+    int64_t startIdx = -1;
+    int64_t targetIdx = -1;
+    int32_t targetDist = -1;  /// best distance to the target so far, -1 while unreached
+    int64_t pagesProcessed = 0;
+
+    Utils::MappedFile mazeFile;
+    Utils::MappedFile distFile;
+
+    /// Active pages by the smallest distance that woke them, entries whose
+    /// key no longer matches activeKey are stale
+    std::priority_queue<std::pair<int32_t, int64_t>, std::vector<std::pair<int32_t, int64_t>>,
+        std::greater<std::pair<int32_t, int64_t>>> activePages;
+    std::unordered_map<int64_t, int32_t> activeKey;
+
+    // Device window: cells and distances of a page and its halo in the layout
+    // of the program, plus one slot past the window with the target bound
+    cl::Buffer cellBuf;
+    cl::Buffer distBuf;
+    cl::Buffer prevBuf;
+    cl::Buffer nextBuf;
+    cl::Buffer prevSizeBuf;
+    cl::Buffer nextSizeBuf;
+    cl::Buffer tileFlagBuf;
+    cl::Buffer foundFlagBuf;
+    int windowCells = 0; /// layout_cells of the window
+    int windowTiles = 0;
+    cl::Kernel tileKernel;
+
+    // Host copies of the window, reused for every page
+    std::vector<int32_t> windowCosts;
+    std::vector<uint8_t> windowCellHost;
+    std::vector<int32_t> windowDist;
+    std::vector<int32_t> windowDistBefore;
+};
+
+/**
+ * @brief Map the maze, create the distance file and activate the page of the start cell
+ * @param clContext OpenCL context
+ * @param clProgram Uniform program, provides expand_tiles
+ * @param mazePath Maze file, width * height bytes with 1 for walls
+ * @param distPath Distance file to create, 4 bytes per cell
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Row-major start cell index
+ * @param targetIdx Row-major target cell index
+ * @param streamingState State to fill, windowSize and layout are read from it
+ * @return false if a file can not be mapped or the start is a wall
+ */
+bool initializeStreamingState(
+    const Compute::CLContext& clContext,
+    const Compute::CLProgram& clProgram,
+    const std::string& mazePath,
+    const std::string& distPath,
+    int64_t width,
+    int64_t height,
+    int64_t startIdx,
+    int64_t targetIdx,
+    StreamingState& streamingState
+);
+
+/**
+ * @brief Relax active pages until none is left or maxPages were processed
+ *
+ * Pages are processed in the order of their smallest woken distance. Pages
+ * woken at or past the target distance are dropped, they can not improve it.
+ *
+ * @param queue OpenCL command queue
+ * @param streamingState State from initializeStreamingState
+ * @param maxPages Number of pages to process, 0 or less runs until the search ends
+ * @return true once no page is active and the target was reached, its distance is then final
+ */
+bool runStreaming(cl::CommandQueue& queue, StreamingState& streamingState, int maxPages);
+
+/**
+ * @brief Number of pages waiting in the scheduler
+ */
+size_t activePageCount(const StreamingState& streamingState);
+
+/**
+ * @brief Copy all distances into a row-major vector, only for mazes that fit into memory
+ * @param streamingState State of a run
+ * @param dist Receives width * height distances, -1 for unreached cells
+ */
+void readStreamingDistances(const StreamingState& streamingState, std::vector<int32_t>& dist);
+
+/**
+ * @brief Walk back from the target through the distance file
+ * @param streamingState State of a finished run
+ * @return Cell indices from start to target, empty if the target was not reached
+ */
+std::vector<int64_t> extractStreamingPath(const StreamingState& streamingState);
+
+} // namespace Maze
@@ -0,0 +1,282 @@
+#include "strips.h"
+#include "maze.h"
+#include <algorithm>
+#include <iostream>
+
+namespace Maze {
+
+bool initializeStripState(
+    Compute::CLDeviceGroup& deviceGroup,
+    const Compute::CLProgram& clProgram,
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    StripState& stripState
+)
+{
+    auto& st = stripState;
+    if (hostMazeCosts[startIdx] < 0)
+    {
+        std::cerr << "Strip start cell is a wall." << std::endl;
+        return false;
+    }
+
+    st.width = width;
+    st.height = height;
+    st.exchangedCells = 0;
+    st.strips.clear();
+
+    // Strips of two rows or more, so the rows along the upper and lower border differ
+    const int count = static_cast<int>(std::max<size_t>(std::min<size_t>(deviceGroup.deviceCount(), height / 2), 1));
+    const int startRow = startIdx / width;
+    for (int i = 0; i < count; ++i)
+    {
+        Strip s;
+        s.device = i;
+        s.ownedBegin = static_cast<int>(static_cast<int64_t>(i) * height / count);
+        s.ownedEnd = static_cast<int>(static_cast<int64_t>(i + 1) * height / count);
+        s.firstRow = s.ownedBegin - (i > 0 ? 1 : 0);
+        s.rows = s.ownedEnd + (i < count - 1 ? 1 : 0) - s.firstRow;
+
+        // Encoded from the stored rows only, so no move leaves the strip
+        const size_t cells = static_cast<size_t>(s.rows) * width;
+        const std::vector<int32_t> costs(
+            hostMazeCosts.begin() + static_cast<size_t>(s.firstRow) * width,
+            hostMazeCosts.begin() + static_cast<size_t>(s.firstRow) * width + cells);
+        const std::vector<uint16_t> words = encodeCells(costs, width, s.rows);
+        std::vector<uint8_t> cellBytes(words.size());
+        std::transform(words.begin(), words.end(), cellBytes.begin(), [](uint16_t w) { return static_cast<uint8_t>(w); });
+
+        // The start is set in every strip that stores it, halo copies included,
+        // but only its owner expands it
+        std::vector<int32_t> dist(cells, -1);
+        const bool storesStart = startRow >= s.firstRow && startRow < s.firstRow + s.rows;
+        const int32_t localStart = startIdx - s.firstRow * width;
+        if (storesStart)
+            dist[localStart] = 0;
+        const bool ownsStart = startRow >= s.ownedBegin && startRow < s.ownedEnd;
+        s.wfSize = ownsStart ? 1 : 0;
+
+        // A cell enters a list at most once per step, so lists of all cells never overflow
+        std::vector<int32_t> wavefront(cells, -1);
+        wavefront[0] = ownsStart ? localStart : -1;
+        uint8_t found = 0;
+
+        const auto& context = deviceGroup.getContext();
+        s.cellBuf = cl::Buffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(uint8_t) * cells, cellBytes.data());
+        s.distBuf = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(int32_t) * cells, dist.data());
+        s.prevBuf = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(int32_t) * cells, wavefront.data());
+        s.nextBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t) * cells);
+        s.prevSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(int32_t), &s.wfSize);
+        s.nextSizeBuf = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(int32_t));
+        s.foundFlagBuf = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(uint8_t), &found);
+        s.kernel = cl::Kernel(clProgram.getProgram(), "expand_wave_idxs");
+
+        s.topHalo.assign(width, -1);
+        s.topOwned.assign(width, -1);
+        s.bottomOwned.assign(width, -1);
+        s.bottomHalo.assign(width, -1);
+
+        std::cout << "Strip " << i << ": rows " << s.ownedBegin << " to " << s.ownedEnd - 1
+                  << " on " << deviceGroup.getDevice(s.device).getInfo<CL_DEVICE_NAME>() << std::endl;
+        st.strips.push_back(std::move(s));
+    }
+
+    return true;
+}
+
+/**
+ * @brief Merge the halo copy of a row with the owner's row
+ *
+ * A cell only reached in the halo joins the owner's frontier, a cell only
+ * reached by the owner updates the halo so the neighbor does not reach it a
+ * second time. In a level synchronous BFS both copies never hold different
+ * distances.
+ *
+ * @param ownedChanged Set if the owner's row changed
+ * @param haloChanged Set if the halo row changed
+ * @param additions Receives the local indices the owner has to expand
+ */
+static void mergeBorderRow(
+    std::vector<int32_t>& halo,
+    std::vector<int32_t>& owned,
+    int ownedOffset,
+    bool& ownedChanged,
+    bool& haloChanged,
+    std::vector<int32_t>& additions)
+{
+    for (size_t x = 0; x < owned.size(); ++x)
+    {
+        if (owned[x] < 0 && halo[x] >= 0)
+        {
+            owned[x] = halo[x];
+            additions.push_back(ownedOffset + static_cast<int32_t>(x));
+            ownedChanged = true;
+        }
+        else if (halo[x] < 0 && owned[x] >= 0)
+        {
+            halo[x] = owned[x];
+            haloChanged = true;
+        }
+    }
+}
+
+bool stepStrips(
+    int& step,
+    int& currentWfSize,
+    Compute::CLDeviceGroup& deviceGroup,
+    int targetIdx,
+    StripState& stripState
+)
+{
+    auto& st = stripState;
+    const int width = st.width;
+    const size_t rowBytes = sizeof(int32_t) * width;
+    const int targetRow = targetIdx / width;
+
+    // All devices expand their strip side by side
+    for (Strip& s : st.strips)
+    {
+        if (s.wfSize == 0)
+            continue;
+
+        cl::CommandQueue& queue = deviceGroup.getQueue(s.device);
+        const bool ownsTarget = targetRow >= s.ownedBegin && targetRow < s.ownedEnd;
+        queue.enqueueFillBuffer(s.nextSizeBuf, 0, 0, sizeof(int32_t));
+        s.kernel.setArg(0, width);
+        s.kernel.setArg(1, s.rows);
+        s.kernel.setArg(2, s.cellBuf);
+        s.kernel.setArg(3, s.prevBuf);
+        s.kernel.setArg(4, s.prevSizeBuf);
+        s.kernel.setArg(5, s.nextBuf);
+        s.kernel.setArg(6, s.nextSizeBuf);
+        s.kernel.setArg(7, width * s.rows);
+        s.kernel.setArg(8, s.distBuf);
+        s.kernel.setArg(9, ownsTarget ? targetIdx - s.firstRow * width : -1);
+        s.kernel.setArg(10, s.foundFlagBuf);
+        queue.enqueueNDRangeKernel(s.kernel, cl::NullRange, cl::NDRange(s.wfSize), cl::NullRange);
+
+        std::swap(s.prevBuf, s.nextBuf);
+        std::swap(s.prevSizeBuf, s.nextSizeBuf);
+    }
+
+    // Only the frontier sizes and the rows along the strip borders come back
+    for (size_t i = 0; i < st.strips.size(); ++i)
+    {
+        Strip& s = st.strips[i];
+        cl::CommandQueue& queue = deviceGroup.getQueue(s.device);
+        queue.enqueueReadBuffer(s.prevSizeBuf, CL_FALSE, 0, sizeof(int32_t), &s.wfSize);
+        queue.enqueueReadBuffer(s.foundFlagBuf, CL_FALSE, 0, sizeof(uint8_t), &s.found);
+        if (i > 0)
+        {
+            queue.enqueueReadBuffer(s.distBuf, CL_FALSE, 0, rowBytes, s.topHalo.data());
+            queue.enqueueReadBuffer(s.distBuf, CL_FALSE, rowBytes * (s.ownedBegin - s.firstRow), rowBytes, s.topOwned.data());
+        }
+        if (i + 1 < st.strips.size())
+        {
+            queue.enqueueReadBuffer(s.distBuf, CL_FALSE, rowBytes * (s.ownedEnd - 1 - s.firstRow), rowBytes, s.bottomOwned.data());
+            queue.enqueueReadBuffer(s.distBuf, CL_FALSE, rowBytes * (s.ownedEnd - s.firstRow), rowBytes, s.bottomHalo.data());
+        }
+    }
+    for (Strip& s : st.strips)
+        deviceGroup.getQueue(s.device).finish();
+
+    bool found = false;
+    for (const Strip& s : st.strips)
+        found = found || s.found;
+
+    // Hand the cells reached across each border to their owners
+    std::vector<std::vector<int32_t>> additions(st.strips.size());
+    std::vector<uint8_t> topChanged(st.strips.size(), 0);
+    std::vector<uint8_t> bottomChanged(st.strips.size(), 0);
+    for (size_t i = 0; i + 1 < st.strips.size(); ++i)
+    {
+        Strip& upper = st.strips[i];
+        Strip& lower = st.strips[i + 1];
+        bool upperOwned = false, upperHalo = false, lowerOwned = false, lowerHalo = false;
+        mergeBorderRow(upper.bottomHalo, lower.topOwned, (lower.ownedBegin - lower.firstRow) * width,
+            lowerOwned, upperHalo, additions[i + 1]);
+        mergeBorderRow(lower.topHalo, upper.bottomOwned, (upper.ownedEnd - 1 - upper.firstRow) * width,
+            upperOwned, lowerHalo, additions[i]);
+        bottomChanged[i] = upperOwned || upperHalo;
+        topChanged[i + 1] = lowerOwned || lowerHalo;
+    }
+
+    currentWfSize = 0;
+    for (size_t i = 0; i < st.strips.size(); ++i)
+    {
+        Strip& s = st.strips[i];
+        cl::CommandQueue& queue = deviceGroup.getQueue(s.device);
+        if (topChanged[i])
+        {
+            queue.enqueueWriteBuffer(s.distBuf, CL_FALSE, 0, rowBytes, s.topHalo.data());
+            queue.enqueueWriteBuffer(s.distBuf, CL_FALSE, rowBytes * (s.ownedBegin - s.firstRow), rowBytes, s.topOwned.data());
+        }
+        if (bottomChanged[i])
+        {
+            queue.enqueueWriteBuffer(s.distBuf, CL_FALSE, rowBytes * (s.ownedEnd - 1 - s.firstRow), rowBytes, s.bottomOwned.data());
+            queue.enqueueWriteBuffer(s.distBuf, CL_FALSE, rowBytes * (s.ownedEnd - s.firstRow), rowBytes, s.bottomHalo.data());
+        }
+        if (!additions[i].empty())
+        {
+            queue.enqueueWriteBuffer(s.prevBuf, CL_FALSE, sizeof(int32_t) * s.wfSize,
+                sizeof(int32_t) * additions[i].size(), additions[i].data());
+            s.wfSize += static_cast<int>(additions[i].size());
+            queue.enqueueWriteBuffer(s.prevSizeBuf, CL_FALSE, 0, sizeof(int32_t), &s.wfSize);
+            st.exchangedCells += static_cast<int64_t>(additions[i].size());
+        }
+        currentWfSize += s.wfSize;
+    }
+    for (Strip& s : st.strips)
+        deviceGroup.getQueue(s.device).finish();
+
+    if (found)
+    {
+        std::cout << "Target found at step " << step << " on " << st.strips.size() << " strips, "
+                  << st.exchangedCells << " cells exchanged" << std::endl;
+        return true;
+    }
+
+    if (currentWfSize == 0)
+    {
+        std::cout << "No more cells to expand - path not found." << std::endl;
+    }
+    return false;
+}
+
+bool runStrips(
+    int& step,
+    int& currentWfSize,
+    Compute::CLDeviceGroup& deviceGroup,
+    int targetIdx,
+    StripState& stripState,
+    int maxSteps
+)
+{
+    for (int i = 0; (maxSteps <= 0 || i < maxSteps) && currentWfSize > 0; ++i)
+    {
+        const bool found = stepStrips(step, currentWfSize, deviceGroup, targetIdx, stripState);
+        ++step;
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+void readStripDistances(Compute::CLDeviceGroup& deviceGroup, StripState& stripState, std::vector<int32_t>& dist)
+{
+    const auto& st = stripState;
+    dist.resize(static_cast<size_t>(st.width) * st.height);
+    for (const Strip& s : st.strips)
+    {
+        const size_t rowBytes = sizeof(int32_t) * st.width;
+        deviceGroup.getQueue(s.device).enqueueReadBuffer(
+            s.distBuf, CL_TRUE,
+            rowBytes * (s.ownedBegin - s.firstRow),
+            rowBytes * (s.ownedEnd - s.ownedBegin),
+            dist.data() + static_cast<size_t>(s.ownedBegin) * st.width);
+    }
+}
+
+} // namespace Maze
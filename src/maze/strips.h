@@ -0,0 +1,121 @@
+#pragma once
+
+#define CL_HPP_TARGET_OPENCL_VERSION 300
+#include <CL/opencl.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "../compute/cl_device_group.h"
+#include "../compute/cl_program.h"
+
+namespace Maze {
+
+/**
+ * @brief Rows of the maze owned by one device of a CLDeviceGroup
+ *
+ * The device holds its rows plus one halo row on each side that has a
+ * neighbor strip, local index (y - firstRow) * width + x.
+ */
+struct Strip {
+    size_t device = 0;
+    int ownedBegin = 0;  /// first owned row of the maze
+    int ownedEnd = 0;    /// one past the last owned row
+    int firstRow = 0;    /// first row stored on the device, ownedBegin - 1 with a halo above
+    int rows = 0;        /// stored rows, owned plus halo
+    int wfSize = 0;
+
+    cl::Buffer cellBuf;
+    cl::Buffer distBuf;
+    cl::Buffer prevBuf;
+    cl::Buffer nextBuf;
+    cl::Buffer prevSizeBuf;
+    cl::Buffer nextSizeBuf;
+    cl::Buffer foundFlagBuf;
+    cl::Kernel kernel;
+
+    // Host copies of the rows along the strip borders, see exchangeHalos
+    std::vector<int32_t> topHalo;
+    std::vector<int32_t> topOwned;
+    std::vector<int32_t> bottomOwned;
+    std::vector<int32_t> bottomHalo;
+    uint8_t found = 0;
+};
+
+/**
+ * @brief Uniform BFS split into horizontal strips over the devices of a group
+ *
+ * Every step all devices expand their own wavefront at the same time. After
+ * the step only the rows along the strip borders travel: a cell a strip
+ * reached in its halo row is handed to the frontier of the owner, and the
+ * owner's border row refreshes the halo copy of its neighbor. Each device
+ * only stores its strip, so a solve can use the memory of all devices.
+ */
+struct StripState {
+    std::vector<Strip> strips;
+    int width = 0;
+    int height = 0;
+    int64_t exchangedCells = 0; /// frontier cells handed across strip borders
+};
+
+/**
+ * @brief Split the maze into one strip per device and seed the start cell
+ * @param deviceGroup Devices to spread the maze over
+ * @param clProgram Uniform program built for all devices of the group with -DCELL_LAYOUT=0
+ * @param hostMazeCosts Row-major cell costs, negative for walls
+ * @param width Maze width
+ * @param height Maze height
+ * @param startIdx Row-major start cell index
+ * @param stripState State to fill
+ * @return false if the start is a wall
+ */
+bool initializeStripState(
+    Compute::CLDeviceGroup& deviceGroup,
+    const Compute::CLProgram& clProgram,
+    const std::vector<int32_t>& hostMazeCosts,
+    int width,
+    int height,
+    int startIdx,
+    StripState& stripState
+);
+
+/**
+ * @brief Expand the wavefronts of all strips by one level and exchange their borders
+ * @param step Step counter, reports the level
+ * @param currentWfSize Receives the summed frontier size of all strips
+ * @param deviceGroup Devices the strips were created on
+ * @param targetIdx Row-major target cell index
+ * @param stripState State from initializeStripState
+ * @return true if the target was found
+ */
+bool stepStrips(
+    int& step,
+    int& currentWfSize,
+    Compute::CLDeviceGroup& deviceGroup,
+    int targetIdx,
+    StripState& stripState
+);
+
+/**
+ * @brief Run stepStrips until the target is found, the frontier is empty or maxSteps were taken
+ * @param maxSteps Steps to run, 0 or less runs until the search ends
+ * @return true if the target was found
+ */
+bool runStrips(
+    int& step,
+    int& currentWfSize,
+    Compute::CLDeviceGroup& deviceGroup,
+    int targetIdx,
+    StripState& stripState,
+    int maxSteps
+);
+
+/**
+ * @brief Gather the owned rows of all strips into a row-major distance field
+ * @param deviceGroup Devices the strips were created on
+ * @param stripState State of a run
+ * @param dist Receives width * height distances, -1 for unreached cells
+ */
+void readStripDistances(Compute::CLDeviceGroup& deviceGroup, StripState& stripState, std::vector<int32_t>& dist);
+
+} // namespace Maze
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <regex>
 
 namespace Utils {
 
@@ -18,4 +19,36 @@ std::string readFile(const std::string& filepath)
     return buffer.str();
 }
 
+std::string readSourceFile(const std::string& filepath)
+{
+    std::string source = readFile(filepath);
+    if (source.empty())
+        return source;
+
+    const size_t slash = filepath.find_last_of("/\\");
+    const std::string dir = (slash == std::string::npos) ? "" : filepath.substr(0, slash + 1);
+
+    static const std::regex includeLine(R"re(^\s*#\s*include\s*"([^"]+)".*)re");
+    std::string expanded;
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::smatch match;
+        if (std::regex_match(line, match, includeLine))
+        {
+            const std::string included = readSourceFile(dir + match[1].str());
+            if (included.empty())
+                return "";
+            expanded += included;
+            if (expanded.back() != '\n')
+                expanded += '\n';
+            continue;
+        }
+        expanded += line;
+        expanded += '\n';
+    }
+    return expanded;
+}
+
 } // namespace Utils
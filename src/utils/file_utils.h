@@ -11,4 +11,16 @@ namespace Utils {
  */
 std::string readFile(const std::string& filepath);
 
+/**
+ * @brief Read a kernel or shader source and expand its local includes
+ *
+ * Lines of the form #include "file" are replaced by the contents of that file,
+ * relative to the directory of the including file. The OpenCL and GLSL
+ * compilers do not resolve includes from a source string on their own.
+ *
+ * @param filepath Path to the source file
+ * @return Expanded source, or empty string on error
+ */
+std::string readSourceFile(const std::string& filepath);
+
 } // namespace Utils
@@ -0,0 +1,166 @@
+#include "mapped_file.h"
+#include <iostream>
+
+#ifdef PLATFORM_WINDOWS
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Utils {
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef PLATFORM_WINDOWS
+
+bool MappedFile::open(const std::string& filepath, bool writable)
+{
+    close();
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0),
+        FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Failed to open file: " << filepath << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    m_file = file;
+    m_size = static_cast<uint64_t>(size.QuadPart);
+    return map(writable);
+}
+
+bool MappedFile::create(const std::string& filepath, uint64_t size)
+{
+    close();
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Failed to create file: " << filepath << std::endl;
+        return false;
+    }
+
+    // Sparse files only allocate the ranges that are written
+    DWORD bytes = 0;
+    DeviceIoControl(file, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &bytes, nullptr);
+    m_file = file;
+    m_size = size;
+    return map(true);
+}
+
+bool MappedFile::map(bool writable)
+{
+    if (m_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(static_cast<HANDLE>(m_file), nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+        static_cast<DWORD>(m_size >> 32), static_cast<DWORD>(m_size), nullptr);
+    if (m_mapping)
+        m_data = static_cast<uint8_t*>(MapViewOfFile(static_cast<HANDLE>(m_mapping), writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        std::cerr << "Failed to map file of " << m_size << " bytes" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+    if (m_file)
+        CloseHandle(static_cast<HANDLE>(m_file));
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filepath, bool writable)
+{
+    close();
+    m_fd = ::open(filepath.c_str(), writable ? O_RDWR : O_RDONLY);
+    if (m_fd < 0)
+    {
+        std::cerr << "Failed to open file: " << filepath << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    fstat(m_fd, &info);
+    m_size = static_cast<uint64_t>(info.st_size);
+    return map(writable);
+}
+
+bool MappedFile::create(const std::string& filepath, uint64_t size)
+{
+    close();
+    m_fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0)
+    {
+        std::cerr << "Failed to create file: " << filepath << std::endl;
+        return false;
+    }
+
+    // Extending a file leaves a hole, no disk space is used until a page is written
+    if (ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+    {
+        std::cerr << "Failed to resize file: " << filepath << std::endl;
+        close();
+        return false;
+    }
+    m_size = size;
+    return map(true);
+}
+
+bool MappedFile::map(bool writable)
+{
+    if (m_size == 0)
+    {
+        close();
+        return false;
+    }
+
+    void* data = mmap(nullptr, m_size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, m_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "Failed to map file of " << m_size << " bytes" << std::endl;
+        close();
+        return false;
+    }
+    m_data = static_cast<uint8_t*>(data);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+        munmap(m_data, m_size);
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+}
+
+#endif
+
+} // namespace Utils
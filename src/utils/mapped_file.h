@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Utils {
+
+/**
+ * @brief File mapped into the address space, the OS pages it in and out on demand
+ *
+ * Only the pages that are touched take memory, so a file can be much larger
+ * than the RAM of the machine. Files created by create() are sparse and read
+ * as zeros until written.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    // Disable copy and move, the mapping is tied to this object
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    /**
+     * @brief Map an existing file
+     * @param filepath Path to the file
+     * @param writable Map it for writing, writes go back to the file
+     * @return false if the file can not be opened or mapped
+     */
+    bool open(const std::string& filepath, bool writable);
+
+    /**
+     * @brief Create or truncate a zero filled file of the given size and map it for writing
+     * @param filepath Path to the file
+     * @param size File size in bytes
+     * @return false if the file can not be created or mapped
+     */
+    bool create(const std::string& filepath, uint64_t size);
+
+    /**
+     * @brief Unmap and close the file, does nothing if nothing is mapped
+     */
+    void close();
+
+    uint8_t* data() { return m_data; }
+    const uint8_t* data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+    bool isOpen() const { return m_data != nullptr; }
+
+private:
+    bool map(bool writable);
+
+    uint8_t* m_data = nullptr;
+    uint64_t m_size = 0;
+#ifdef PLATFORM_WINDOWS
+    void* m_file = nullptr;    // HANDLE of the file
+    void* m_mapping = nullptr; // HANDLE of the file mapping
+#else
+    int m_fd = -1;
+#endif
+};
+
+} // namespace Utils
@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace Utils {
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_workers.push_back(std::make_unique<Worker>());
+
+    // Worker 0 is the thread calling parallelFor
+    for (unsigned i = 1; i < threadCount; ++i)
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+void ThreadPool::parallelFor(
+    size_t count,
+    size_t grain,
+    const std::function<void(size_t, size_t, unsigned)>& fn
+)
+{
+    if (count == 0)
+        return;
+
+    // A few chunks per worker leave room for stealing
+    const size_t workers = m_workers.size();
+    const size_t chunkSize = std::max<size_t>(std::max<size_t>(grain, 1), (count + 4 * workers - 1) / (4 * workers));
+    const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    if (chunkCount == 1 || workers == 1)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    m_pending.store(chunkCount);
+    for (size_t c = 0; c < chunkCount; ++c)
+    {
+        Worker& worker = *m_workers[c % workers];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.chunks.push_back({ c * chunkSize, std::min(count, (c + 1) * chunkSize) });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &fn;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runChunks(0, fn);
+
+    // Helpers may still be running their last chunk
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending.load() == 0 && m_active == 0; });
+    m_job = nullptr;
+}
+
+bool ThreadPool::popLocal(unsigned worker, Chunk& chunk)
+{
+    Worker& own = *m_workers[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.chunks.empty())
+        return false;
+    chunk = own.chunks.back();
+    own.chunks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(unsigned worker, Chunk& chunk)
+{
+    const unsigned workers = size();
+    for (unsigned i = 1; i < workers; ++i)
+    {
+        Worker& victim = *m_workers[(worker + i) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.chunks.empty())
+            continue;
+        chunk = victim.chunks.front();
+        victim.chunks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runChunks(unsigned worker, const Job& job)
+{
+    Chunk chunk;
+    while (popLocal(worker, chunk) || steal(worker, chunk))
+    {
+        job(chunk.begin, chunk.end, worker);
+        if (m_pending.fetch_sub(1) == 1)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(unsigned worker)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        const Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || (m_job && m_generation != seen); });
+            if (m_stop)
+                return;
+            seen = m_generation;
+            job = m_job;
+            ++m_active;
+        }
+
+        runChunks(worker, *job);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+        }
+        m_done.notify_all();
+    }
+}
+
+} // namespace Utils
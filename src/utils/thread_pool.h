@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+
+/**
+ * @brief Fixed size thread pool for parallel loops with work stealing
+ *
+ * parallelFor splits a range into chunks that are dealt round robin to the
+ * workers' deques. A worker pops chunks from the back of its own deque and
+ * steals from the front of the others once it runs dry. The calling thread
+ * takes part as worker 0.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param threadCount Number of workers including the calling thread, 0 for all cores
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    // Disable copy and move
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    /**
+     * @brief Run fn over [0, count) and wait for it to finish
+     * @param count Number of items
+     * @param grain Smallest number of items per chunk
+     * @param fn Called as fn(begin, end, worker) for every chunk, must not throw
+     */
+    void parallelFor(
+        size_t count,
+        size_t grain,
+        const std::function<void(size_t, size_t, unsigned)>& fn
+    );
+
+    unsigned size() const { return static_cast<unsigned>(m_workers.size()); }
+
+private:
+    struct Chunk
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    using Job = std::function<void(size_t, size_t, unsigned)>;
+
+    bool popLocal(unsigned worker, Chunk& chunk);
+    bool steal(unsigned worker, Chunk& chunk);
+    void runChunks(unsigned worker, const Job& job);
+    void workerLoop(unsigned worker);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Job* m_job = nullptr;
+    uint64_t m_generation = 0;
+    unsigned m_active = 0;           // helper threads inside the current job
+    std::atomic<size_t> m_pending{0}; // chunks not finished yet
+    bool m_stop = false;
+};
+
+} // namespace Utils